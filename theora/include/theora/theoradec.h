@@ -100,6 +100,96 @@ extern "C" {
 #define TH_DECCTL_SET_TELEMETRY_QI (13)
 /**Enables telemetry and sets the bitstream breakdown visualization mode */
 #define TH_DECCTL_SET_TELEMETRY_BITS (15)
+/**Sets the number of threads used to reconstruct each frame.
+ * After the tokens of a frame are unpacked, the three color planes are
+ *  reconstructed independently, and within each plane the loop filter and
+ *  post-processing trail one MCU behind reconstruction on a separate thread.
+ * The output is bit-exact with single-threaded decoding.
+ * While more than one thread is in use, a striped decode callback is invoked
+ *  once per frame with the complete image instead of once per MCU.
+ *
+ * \param[in] _buf int: The number of threads, including the thread calling
+ *                      th_decode_packetin().
+ *                      1 (the default) decodes on the calling thread alone.
+ *                      There is no benefit to using more than 6.
+ * \retval TH_EFAULT  \a _dec_ctx or \a _buf is <tt>NULL</tt>, or the threads
+ *                     could not be started.
+ * \retval TH_EINVAL  \a _buf_sz is not <tt>sizeof(int)</tt>, or the thread
+ *                     count is less than 1.
+ * \retval TH_EIMPL   Threads are not supported by this implementation.*/
+#define TH_DECCTL_SET_THREAD_COUNT (0x8001)
+/**Resets the decoder to the state it was in just after th_decode_alloc(),
+ *  keeping its frame and post-processing buffers.
+ * This is much cheaper than freeing the decoder and allocating a new one when
+ *  restarting decoding at a new position in the stream, e.g., after a seek.
+ * The granule position is reset to that of a new decoder, so
+ *  #TH_DECCTL_SET_GRANPOS should be used afterwards as it would be with a
+ *  newly allocated one.
+ * The post-processing level, striped decode callback, and thread count are
+ *  left unchanged.
+ *
+ * \param[in] _buf Ignored.
+ * \retval TH_EFAULT  \a _dec_ctx is <tt>NULL</tt>.*/
+#define TH_DECCTL_RESET (0x8003)
+/**Gets the size of a snapshot of the current decoder state.
+ * A snapshot holds everything the decoding of the following frames depends
+ *  on: the reference frames, the frame counters used to compute the granule
+ *  position, and the DC quantization indices tracked for post-processing.
+ * The size depends on the state, so it should be queried again before each
+ *  #TH_DECCTL_SAVE_SNAPSHOT.
+ *
+ * \param[out] _buf <tt>size_t</tt>: The size of the snapshot in bytes.
+ * \retval TH_EFAULT  \a _dec_ctx or \a _buf is <tt>NULL</tt>.
+ * \retval TH_EINVAL  \a _buf_sz is not <tt>sizeof(size_t)</tt>, or no frame
+ *                     has been decoded yet.*/
+#define TH_DECCTL_GET_SNAPSHOT_SIZE (0x8005)
+/**Saves a snapshot of the current decoder state.
+ * Restoring it later with #TH_DECCTL_RESTORE_SNAPSHOT allows decoding to
+ *  continue with the packet following the last one decoded, without going
+ *  back to the preceding key frame.
+ * A snapshot can only be restored into a decoder of the same stream.
+ *
+ * \param[out] _buf An application-provided buffer at least as large as the
+ *                   size returned by #TH_DECCTL_GET_SNAPSHOT_SIZE.
+ * \retval TH_EFAULT  \a _dec_ctx or \a _buf is <tt>NULL</tt>.
+ * \retval TH_EINVAL  \a _buf_sz is too small, or no frame has been decoded
+ *                     yet.*/
+#define TH_DECCTL_SAVE_SNAPSHOT (0x8007)
+/**Restores a decoder state saved with #TH_DECCTL_SAVE_SNAPSHOT.
+ * The decoder is left as it was just after decoding the frame the snapshot
+ *  was taken at, including the granule position, so #TH_DECCTL_SET_GRANPOS
+ *  is not needed afterwards.
+ * If the first packet decoded afterwards is a dropped frame, the
+ *  un-post-processed frame is returned for it.
+ * The post-processing level, striped decode callback, and thread count are
+ *  left unchanged.
+ *
+ * \param[in] _buf The snapshot.
+ * \retval TH_EFAULT  \a _dec_ctx or \a _buf is <tt>NULL</tt>, or memory could
+ *                     not be allocated.
+ * \retval TH_EINVAL  \a _buf_sz does not match the size of the snapshot, or
+ *                     it was not made by a decoder with the same frame
+ *                     size.*/
+#define TH_DECCTL_RESTORE_SNAPSHOT (0x8009)
+/**Gets which macro blocks of the last decoded frame contain coded fragments.
+ * Each macro block covers 16x16 pixels of the luma plane and the chroma
+ *  pixels at the same position.
+ * Everywhere else the frame is a copy of the previous one, except for pixels
+ *  near the edges of coded macro blocks, which the loop filter and
+ *  post-processing may still change.
+ * If deringing is enabled and the quantizers changed from the previous frame,
+ *  all macro blocks are reported, since deringing depends on them.
+ * All macro blocks of a key frame are coded, and none of a dropped frame
+ *  (#TH_DUPFRAME).
+ *
+ * \param[out] _buf <tt>unsigned char[]</tt>: One byte per macro block, set to
+ *                   1 if it is coded and 0 otherwise.
+ *                  The macro blocks are stored row by row, starting at the top
+ *                   left of the frame, in
+ *                   <tt>(frame_width>>4)*(frame_height>>4)</tt> bytes.
+ * \retval TH_EFAULT  \a _dec_ctx or \a _buf is <tt>NULL</tt>.
+ * \retval TH_EINVAL  \a _buf_sz is not the number of macro blocks.*/
+#define TH_DECCTL_GET_CODED_MBS (0x800B)
 /*@}*/
 
 
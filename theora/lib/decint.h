@@ -23,6 +23,7 @@
 # include "bitpack.h"
 # include "huffdec.h"
 # include "dequant.h"
+# include "decthread.h"
 
 typedef struct th_setup_info         oc_setup_info;
 typedef struct oc_dec_opt_vtable     oc_dec_opt_vtable;
@@ -32,6 +33,11 @@ typedef struct th_dec_ctx            oc_dec_ctx;
 
 
 /*Decoder-specific accelerated functions.*/
+# if defined(OC_X86_ASM)
+#  if !defined(_MSC_VER) || defined(__ANDROID__)
+#   include "x86/x86dec.h"
+#  endif
+# endif
 # if defined(OC_C64X_ASM)
 #  include "c64x/c64xdec.h"
 # endif
@@ -44,10 +50,42 @@ typedef struct th_dec_ctx            oc_dec_ctx;
 #   define oc_dec_dc_unpredict_mcu_plane(_dec,_pipe,_pli) \
  ((*(_dec)->opt_vtable.dc_unpredict_mcu_plane)(_dec,_pipe,_pli))
 #  endif
+#  if !defined(oc_filter_hedge)
+#   define oc_filter_hedge(_dec,_dst,_dst_ystride,_src,_src_ystride,_qstep, \
+ _flimit,_variance0,_variance1) \
+ ((*(_dec)->opt_vtable.filter_hedge)(_dst,_dst_ystride,_src,_src_ystride, \
+  _qstep,_flimit,_variance0,_variance1))
+#  endif
+#  if !defined(oc_filter_vedge)
+#   define oc_filter_vedge(_dec,_dst,_dst_ystride,_qstep,_flimit,_variances) \
+ ((*(_dec)->opt_vtable.filter_vedge)(_dst,_dst_ystride,_qstep,_flimit, \
+  _variances))
+#  endif
+#  if !defined(oc_dering_block)
+#   define oc_dering_block(_dec,_idata,_ystride,_b,_dc_scale,_sharp_mod, \
+ _strong) \
+ ((*(_dec)->opt_vtable.dering_block)(_idata,_ystride,_b,_dc_scale, \
+  _sharp_mod,_strong))
+#  endif
 # else
 #  if !defined(oc_dec_dc_unpredict_mcu_plane)
 #   define oc_dec_dc_unpredict_mcu_plane oc_dec_dc_unpredict_mcu_plane_c
 #  endif
+#  if !defined(oc_filter_hedge)
+#   define oc_filter_hedge(_dec,_dst,_dst_ystride,_src,_src_ystride,_qstep, \
+ _flimit,_variance0,_variance1) \
+ oc_filter_hedge_c(_dst,_dst_ystride,_src,_src_ystride, \
+  _qstep,_flimit,_variance0,_variance1)
+#  endif
+#  if !defined(oc_filter_vedge)
+#   define oc_filter_vedge(_dec,_dst,_dst_ystride,_qstep,_flimit,_variances) \
+ oc_filter_vedge_c(_dst,_dst_ystride,_qstep,_flimit,_variances)
+#  endif
+#  if !defined(oc_dering_block)
+#   define oc_dering_block(_dec,_idata,_ystride,_b,_dc_scale,_sharp_mod, \
+ _strong) \
+ oc_dering_block_c(_idata,_ystride,_b,_dc_scale,_sharp_mod,_strong)
+#  endif
 # endif
 
 
@@ -72,6 +110,13 @@ struct th_setup_info{
 struct oc_dec_opt_vtable{
   void (*dc_unpredict_mcu_plane)(oc_dec_ctx *_dec,
    oc_dec_pipeline_state *_pipe,int _pli);
+  void (*filter_hedge)(unsigned char *_dst,int _dst_ystride,
+   const unsigned char *_src,int _src_ystride,int _qstep,int _flimit,
+   int *_variance0,int *_variance1);
+  void (*filter_vedge)(unsigned char *_dst,int _dst_ystride,
+   int _qstep,int _flimit,int *_variances);
+  void (*dering_block)(unsigned char *_idata,int _ystride,int _b,
+   int _dc_scale,int _sharp_mod,int _strong);
 };
 
 
@@ -145,6 +190,9 @@ struct th_dec_ctx{
   unsigned char         *dc_qis;
   /*The variance of each block.*/
   int                   *variances;
+  /*Whether the quantization indices differ from the previous frame.
+    Deringing uses them for blocks that weren't coded, too.*/
+  int                    pp_qis_changed;
   /*The storage for the post-processed frame buffer.*/
   unsigned char         *pp_frame_data;
   /*Whether or not the post-processsed frame buffer has space for chroma.*/
@@ -156,6 +204,17 @@ struct th_dec_ctx{
   /*The striped decode callback function.*/
   th_stripe_callback     stripe_cb;
   oc_dec_pipeline_state  pipe;
+# if defined(OC_THREADS)
+  /*The number of threads used to reconstruct each frame, including the
+     caller.*/
+  int                    nthreads;
+  /*The thread team used for plane- and wavefront-parallel reconstruction,
+     or NULL when decoding on the calling thread alone.*/
+  oc_dec_team           *team;
+  /*Private copies of the pipeline state, one for each color plane, used
+     while the team is reconstructing a frame.*/
+  oc_dec_pipeline_state *plane_pipes;
+# endif
 # if defined(OC_DEC_USE_VTABLE)
   /*Table for decoder acceleration functions.*/
   oc_dec_opt_vtable      opt_vtable;
@@ -182,5 +241,12 @@ void oc_dec_accel_init_c(oc_dec_ctx *_dec);
 
 void oc_dec_dc_unpredict_mcu_plane_c(oc_dec_ctx *_dec,
  oc_dec_pipeline_state *_pipe,int _pli);
+void oc_filter_hedge_c(unsigned char *_dst,int _dst_ystride,
+ const unsigned char *_src,int _src_ystride,int _qstep,int _flimit,
+ int *_variance0,int *_variance1);
+void oc_filter_vedge_c(unsigned char *_dst,int _dst_ystride,
+ int _qstep,int _flimit,int *_variances);
+void oc_dering_block_c(unsigned char *_idata,int _ystride,int _b,
+ int _dc_scale,int _sharp_mod,int _strong);
 
 #endif
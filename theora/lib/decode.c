@@ -362,6 +362,9 @@ void oc_dec_accel_init_c(oc_dec_ctx *_dec){
 # if defined(OC_DEC_USE_VTABLE)
   _dec->opt_vtable.dc_unpredict_mcu_plane=
    oc_dec_dc_unpredict_mcu_plane_c;
+  _dec->opt_vtable.filter_hedge=oc_filter_hedge_c;
+  _dec->opt_vtable.filter_vedge=oc_filter_vedge_c;
+  _dec->opt_vtable.dering_block=oc_dering_block_c;
 # endif
 }
 
@@ -414,8 +417,14 @@ static int oc_dec_init(oc_dec_ctx *_dec,const th_info *_info,
   _dec->dc_qis=NULL;
   _dec->variances=NULL;
   _dec->pp_frame_data=NULL;
+  _dec->pp_qis_changed=0;
   _dec->stripe_cb.ctx=NULL;
   _dec->stripe_cb.stripe_decoded=NULL;
+#if defined(OC_THREADS)
+  _dec->nthreads=1;
+  _dec->team=NULL;
+  _dec->plane_pipes=NULL;
+#endif
 #if defined(HAVE_CAIRO)
   _dec->telemetry=0;
   _dec->telemetry_bits=0;
@@ -427,7 +436,50 @@ static int oc_dec_init(oc_dec_ctx *_dec,const th_info *_info,
   return 0;
 }
 
+#if defined(OC_THREADS)
+static void oc_dec_threads_clear(oc_dec_ctx *_dec){
+  if(_dec->team!=NULL){
+    oc_dec_team_clear(_dec->team);
+    _ogg_free(_dec->team);
+    _dec->team=NULL;
+  }
+  oc_aligned_free(_dec->plane_pipes);
+  _dec->plane_pipes=NULL;
+  _dec->nthreads=1;
+}
+
+static int oc_dec_threads_set(oc_dec_ctx *_dec,int _nthreads){
+  /*There are only six jobs per frame: reconstruction and filtering for each
+     of the three color planes.*/
+  _nthreads=OC_MINI(_nthreads,6);
+  if(_nthreads==_dec->nthreads)return 0;
+  oc_dec_threads_clear(_dec);
+  if(_nthreads<=1)return 0;
+  _dec->plane_pipes=(oc_dec_pipeline_state *)oc_aligned_malloc(
+   3*sizeof(_dec->plane_pipes[0]),16);
+  _dec->team=(oc_dec_team *)_ogg_malloc(sizeof(*_dec->team));
+  if(_dec->plane_pipes==NULL||_dec->team==NULL){
+    oc_aligned_free(_dec->plane_pipes);
+    _dec->plane_pipes=NULL;
+    _ogg_free(_dec->team);
+    _dec->team=NULL;
+    return TH_EFAULT;
+  }
+  if(oc_dec_team_init(_dec->team,_nthreads)<0){
+    _ogg_free(_dec->team);
+    _dec->team=NULL;
+    oc_dec_threads_clear(_dec);
+    return TH_EFAULT;
+  }
+  _dec->nthreads=_nthreads;
+  return 0;
+}
+#endif
+
 static void oc_dec_clear(oc_dec_ctx *_dec){
+#if defined(OC_THREADS)
+  oc_dec_threads_clear(_dec);
+#endif
 #if defined(HAVE_CAIRO)
   _ogg_free(_dec->telemetry_frame_data);
 #endif
@@ -1608,7 +1660,7 @@ static void oc_dec_frags_recon_mcu_plane(oc_dec_ctx *_dec,
 }
 
 /*Filter a horizontal block edge.*/
-static void oc_filter_hedge(unsigned char *_dst,int _dst_ystride,
+void oc_filter_hedge_c(unsigned char *_dst,int _dst_ystride,
  const unsigned char *_src,int _src_ystride,int _qstep,int _flimit,
  int *_variance0,int *_variance1){
   unsigned char       *rdst;
@@ -1662,7 +1714,7 @@ static void oc_filter_hedge(unsigned char *_dst,int _dst_ystride,
 }
 
 /*Filter a vertical block edge.*/
-static void oc_filter_vedge(unsigned char *_dst,int _dst_ystride,
+void oc_filter_vedge_c(unsigned char *_dst,int _dst_ystride,
  int _qstep,int _flimit,int *_variances){
   unsigned char       *rdst;
   const unsigned char *rsrc;
@@ -1747,16 +1799,16 @@ static void oc_dec_deblock_frag_rows(oc_dec_ctx *_dec,
   for(;y<y_end;y+=8){
     qstep=_dec->pp_dc_scale[*dc_qi];
     flimit=(qstep*3)>>2;
-    oc_filter_hedge(dst,dst_ystride,src-src_ystride,src_ystride,
+    oc_filter_hedge(_dec,dst,dst_ystride,src-src_ystride,src_ystride,
      qstep,flimit,variance,variance+nhfrags);
     variance++;
     dc_qi++;
     for(x=8;x<width;x+=8){
       qstep=_dec->pp_dc_scale[*dc_qi];
       flimit=(qstep*3)>>2;
-      oc_filter_hedge(dst+x,dst_ystride,src+x-src_ystride,src_ystride,
+      oc_filter_hedge(_dec,dst+x,dst_ystride,src+x-src_ystride,src_ystride,
        qstep,flimit,variance,variance+nhfrags);
-      oc_filter_vedge(dst+x-(dst_ystride<<2)-4,dst_ystride,
+      oc_filter_vedge(_dec,dst+x-(dst_ystride<<2)-4,dst_ystride,
        qstep,flimit,variance-1);
       variance++;
       dc_qi++;
@@ -1778,13 +1830,13 @@ static void oc_dec_deblock_frag_rows(oc_dec_ctx *_dec,
     for(x=8;x<width;x+=8){
       qstep=_dec->pp_dc_scale[*dc_qi++];
       flimit=(qstep*3)>>2;
-      oc_filter_vedge(dst+x-(dst_ystride<<3)-4,dst_ystride,
+      oc_filter_vedge(_dec,dst+x-(dst_ystride<<3)-4,dst_ystride,
        qstep,flimit,variance++);
     }
   }
 }
 
-static void oc_dering_block(unsigned char *_idata,int _ystride,int _b,
+void oc_dering_block_c(unsigned char *_idata,int _ystride,int _b,
  int _dc_scale,int _sharp_mod,int _strong){
   static const unsigned char OC_MOD_MAX[2]={24,32};
   static const unsigned char OC_MOD_SHIFT[2]={1,0};
@@ -1930,24 +1982,24 @@ static void oc_dec_dering_frag_rows(oc_dec_ctx *_dec,th_img_plane *_img,
       var=*variance;
       b=(x<=0)|(x+8>=width)<<1|(y<=0)<<2|(y+8>=height)<<3;
       if(strong&&var>sthresh){
-        oc_dering_block(idata+x,ystride,b,
+        oc_dering_block(_dec,idata+x,ystride,b,
          _dec->pp_dc_scale[qi],_dec->pp_sharp_mod[qi],1);
         if(_pli||!(b&1)&&*(variance-1)>OC_DERING_THRESH4||
          !(b&2)&&variance[1]>OC_DERING_THRESH4||
          !(b&4)&&*(variance-nhfrags)>OC_DERING_THRESH4||
          !(b&8)&&variance[nhfrags]>OC_DERING_THRESH4){
-          oc_dering_block(idata+x,ystride,b,
+          oc_dering_block(_dec,idata+x,ystride,b,
            _dec->pp_dc_scale[qi],_dec->pp_sharp_mod[qi],1);
-          oc_dering_block(idata+x,ystride,b,
+          oc_dering_block(_dec,idata+x,ystride,b,
            _dec->pp_dc_scale[qi],_dec->pp_sharp_mod[qi],1);
         }
       }
       else if(var>OC_DERING_THRESH2){
-        oc_dering_block(idata+x,ystride,b,
+        oc_dering_block(_dec,idata+x,ystride,b,
          _dec->pp_dc_scale[qi],_dec->pp_sharp_mod[qi],1);
       }
       else if(var>OC_DERING_THRESH1){
-        oc_dering_block(idata+x,ystride,b,
+        oc_dering_block(_dec,idata+x,ystride,b,
          _dec->pp_dc_scale[qi],_dec->pp_sharp_mod[qi],0);
       }
       frag++;
@@ -1959,6 +2011,137 @@ static void oc_dec_dering_frag_rows(oc_dec_ctx *_dec,th_img_plane *_img,
 
 
 
+/*Runs the loop filter, border extension, and out-of-loop post-processing on
+   a single plane of an MCU.
+  Each stage needs a few pixels from the following fragment row, so each one
+   is delayed by one more row than the last, except at the start and end of
+   the frame.
+  _fragy0:    The first fragment row of the MCU in this plane.
+  _fragy_end: The fragment row past the end of the MCU in this plane.
+  _notstart:  Whether this is not the first MCU of the frame.
+  _notdone:   Whether this is not the last MCU of the frame.
+  _edelay:    Returns the number of rows at the end of the MCU that are not yet
+               complete.
+  Return: The number of rows before the start of the MCU that were completed
+   by this call.*/
+static int oc_dec_filter_mcu_plane(oc_dec_ctx *_dec,
+ const oc_dec_pipeline_state *_pipe,int _refi,int _pli,int _fragy0,
+ int _fragy_end,int _notstart,int _notdone,int *_edelay){
+  int pp_offset;
+  int sdelay;
+  int edelay;
+  sdelay=edelay=0;
+  if(_pipe->loop_filter){
+    sdelay+=_notstart;
+    edelay+=_notdone;
+    oc_state_loop_filter_frag_rows(&_dec->state,
+     (signed char *)_pipe->bounding_values,OC_FRAME_SELF,_pli,
+     _fragy0-sdelay,_fragy_end-edelay);
+  }
+  /*To fill the borders, we have an additional two pixel delay, since a
+     fragment in the next row could filter its top edge, using two pixels
+     from a fragment in this row.
+    But there's no reason to delay a full fragment between the two.*/
+  oc_state_borders_fill_rows(&_dec->state,_refi,_pli,
+   (_fragy0-sdelay<<3)-(sdelay<<1),(_fragy_end-edelay<<3)-(edelay<<1));
+  /*Out-of-loop post-processing.*/
+  pp_offset=3*(_pli!=0);
+  if(_pipe->pp_level>=OC_PP_LEVEL_DEBLOCKY+pp_offset){
+    /*Perform de-blocking in one plane.*/
+    sdelay+=_notstart;
+    edelay+=_notdone;
+    oc_dec_deblock_frag_rows(_dec,_dec->pp_frame_buf,
+     _dec->state.ref_frame_bufs[_refi],_pli,
+     _fragy0-sdelay,_fragy_end-edelay);
+    if(_pipe->pp_level>=OC_PP_LEVEL_DERINGY+pp_offset){
+      /*Perform de-ringing in one plane.*/
+      sdelay+=_notstart;
+      edelay+=_notdone;
+      oc_dec_dering_frag_rows(_dec,_dec->pp_frame_buf,_pli,
+       _fragy0-sdelay,_fragy_end-edelay);
+    }
+  }
+  /*If no post-processing is done, we still need to delay a row for the
+     loop filter, thanks to the strange filtering order VP3 chose.*/
+  else if(_pipe->loop_filter){
+    sdelay+=_notstart;
+    edelay+=_notdone;
+  }
+  *_edelay=edelay;
+  return sdelay;
+}
+
+#if defined(OC_THREADS)
+/*Undoes DC prediction and reconstructs one plane of the frame, publishing the
+   number of finished MCUs so the filtering job can follow behind.*/
+static void oc_dec_plane_recon(oc_dec_ctx *_dec,int _pli){
+  oc_dec_pipeline_state *pipe;
+  oc_fragment_plane     *fplane;
+  int                    stripe_fragy;
+  int                    frag_shift;
+  int                    mcui;
+  pipe=_dec->plane_pipes+_pli;
+  fplane=_dec->state.fplanes+_pli;
+  frag_shift=_pli!=0&&!(_dec->state.info.pixel_fmt&2);
+  for(stripe_fragy=mcui=0;stripe_fragy<_dec->state.fplanes[0].nvfrags;
+   stripe_fragy+=pipe->mcu_nvfrags){
+    pipe->fragy0[_pli]=stripe_fragy>>frag_shift;
+    pipe->fragy_end[_pli]=OC_MINI(fplane->nvfrags,
+     pipe->fragy0[_pli]+(pipe->mcu_nvfrags>>frag_shift));
+    oc_dec_dc_unpredict_mcu_plane(_dec,pipe,_pli);
+    oc_dec_frags_recon_mcu_plane(_dec,pipe,_pli);
+    oc_dec_team_progress_set(_dec->team,_pli,++mcui);
+  }
+}
+
+/*Filters one plane of the frame, one MCU behind its reconstruction.
+  The stages only touch rows that the serial pipeline would already have
+   reconstructed at the same point, so the output is identical.*/
+static void oc_dec_plane_filter(oc_dec_ctx *_dec,int _pli){
+  const oc_dec_pipeline_state *pipe;
+  oc_fragment_plane           *fplane;
+  int                          stripe_fragy;
+  int                          frag_shift;
+  int                          mcu_nvfrags;
+  int                          nvfrags;
+  int                          notstart;
+  int                          refi;
+  int                          mcui;
+  pipe=_dec->plane_pipes+_pli;
+  fplane=_dec->state.fplanes+_pli;
+  frag_shift=_pli!=0&&!(_dec->state.info.pixel_fmt&2);
+  mcu_nvfrags=pipe->mcu_nvfrags;
+  nvfrags=_dec->state.fplanes[0].nvfrags;
+  refi=_dec->state.ref_frame_idx[OC_FRAME_SELF];
+  notstart=0;
+  for(stripe_fragy=mcui=0;stripe_fragy<nvfrags;stripe_fragy+=mcu_nvfrags){
+    int fragy0;
+    int fragy_end;
+    int edelay;
+    fragy0=stripe_fragy>>frag_shift;
+    fragy_end=OC_MINI(fplane->nvfrags,fragy0+(mcu_nvfrags>>frag_shift));
+    oc_dec_team_progress_wait(_dec->team,_pli,++mcui);
+    oc_dec_filter_mcu_plane(_dec,pipe,refi,_pli,fragy0,fragy_end,
+     notstart,stripe_fragy+mcu_nvfrags<nvfrags,&edelay);
+    notstart=1;
+  }
+}
+
+/*Jobs 2*pli and 2*pli+1 reconstruct and filter color plane pli.
+  Each filtering job is dispatched after the reconstruction job it waits on,
+   as the thread team requires.*/
+static void oc_dec_team_job(void *_ctx,int _jobi){
+  oc_dec_ctx *dec;
+  dec=(oc_dec_ctx *)_ctx;
+  if(_jobi&1)oc_dec_plane_filter(dec,_jobi>>1);
+  else oc_dec_plane_recon(dec,_jobi>>1);
+  /*Leave this thread's FPU usable, as the serial path does for the caller.*/
+  oc_restore_fpu(&dec->state);
+}
+#endif
+
+
+
 th_dec_ctx *th_decode_alloc(const th_info *_info,const th_setup_info *_setup){
   oc_dec_ctx *dec;
   if(_info==NULL||_setup==NULL)return NULL;
@@ -1971,6 +2154,196 @@ th_dec_ctx *th_decode_alloc(const th_info *_info,const th_setup_info *_setup){
   return dec;
 }
 
+/*Forgets all of the decoded frames, returning the decoder to the state
+   th_decode_alloc() leaves it in while keeping its buffers.
+  Everything else a frame depends on is rewritten by each frame before it is
+   used, except for the DC quantization indices of the uncoded blocks.
+  Those are only valid after a key frame, so they get discarded, just as if
+   post-processing had been enabled in a new decoder.
+  The (much larger) post-processing buffers are kept, but the post-processed
+   frame pointers are set up again before they are next used, since the
+   chroma ones may still point into a reference frame.*/
+static void oc_dec_reset(oc_dec_ctx *_dec){
+  _ogg_free(_dec->dc_qis);
+  _dec->dc_qis=NULL;
+  _dec->pp_frame_state=0;
+  _dec->state.ref_frame_idx[OC_FRAME_GOLD]=
+   _dec->state.ref_frame_idx[OC_FRAME_PREV]=
+   _dec->state.ref_frame_idx[OC_FRAME_GOLD_ORIG]=
+   _dec->state.ref_frame_idx[OC_FRAME_PREV_ORIG]=
+   _dec->state.ref_frame_idx[OC_FRAME_SELF]=
+   _dec->state.ref_frame_idx[OC_FRAME_IO]=-1;
+  _dec->state.ref_frame_data[OC_FRAME_GOLD]=
+   _dec->state.ref_frame_data[OC_FRAME_PREV]=
+   _dec->state.ref_frame_data[OC_FRAME_GOLD_ORIG]=
+   _dec->state.ref_frame_data[OC_FRAME_PREV_ORIG]=
+   _dec->state.ref_frame_data[OC_FRAME_SELF]=
+   _dec->state.ref_frame_data[OC_FRAME_IO]=NULL;
+  _dec->state.frame_type=OC_UNKWN_FRAME;
+  _dec->state.granpos=0;
+  _dec->state.keyframe_num=0;
+  _dec->state.curframe_num=0;
+}
+
+/*The fixed part of a decoder state snapshot.
+  It is followed by the gold reference frame, the previous reference frame
+   (unless it is the same one), and the DC quantization indices (if they are
+   being tracked).*/
+typedef struct{
+  ogg_int64_t keyframe_num;
+  ogg_int64_t curframe_num;
+  ogg_int64_t granpos;
+  size_t      ref_frame_sz;
+  int         frame_type;
+  int         nrefs;
+  int         has_dc_qis;
+}oc_dec_snapshot_header;
+
+/*The reference frames are allocated back to back, each one with its borders
+   and padding, see oc_state_ref_bufs_init().*/
+static size_t oc_dec_ref_frame_sz(const oc_dec_ctx *_dec){
+  return (size_t)(_dec->state.ref_frame_bufs[1][0].data
+   -_dec->state.ref_frame_bufs[0][0].data);
+}
+
+static size_t oc_dec_snapshot_size(const oc_dec_ctx *_dec){
+  size_t sz;
+  sz=sizeof(oc_dec_snapshot_header)+oc_dec_ref_frame_sz(_dec);
+  if(_dec->state.ref_frame_idx[OC_FRAME_GOLD]!=
+   _dec->state.ref_frame_idx[OC_FRAME_PREV]){
+    sz+=oc_dec_ref_frame_sz(_dec);
+  }
+  if(_dec->dc_qis!=NULL)sz+=_dec->state.nfrags*sizeof(_dec->dc_qis[0]);
+  return sz;
+}
+
+static void oc_dec_snapshot_save(const oc_dec_ctx *_dec,unsigned char *_buf){
+  oc_dec_snapshot_header header;
+  size_t                 ref_frame_sz;
+  int                    refi;
+  ref_frame_sz=oc_dec_ref_frame_sz(_dec);
+  header.keyframe_num=_dec->state.keyframe_num;
+  header.curframe_num=_dec->state.curframe_num;
+  header.granpos=_dec->state.granpos;
+  header.ref_frame_sz=ref_frame_sz;
+  header.frame_type=_dec->state.frame_type;
+  header.nrefs=1+(_dec->state.ref_frame_idx[OC_FRAME_GOLD]!=
+   _dec->state.ref_frame_idx[OC_FRAME_PREV]);
+  header.has_dc_qis=_dec->dc_qis!=NULL;
+  memcpy(_buf,&header,sizeof(header));
+  _buf+=sizeof(header);
+  refi=_dec->state.ref_frame_idx[OC_FRAME_GOLD];
+  memcpy(_buf,_dec->state.ref_frame_handle+refi*ref_frame_sz,ref_frame_sz);
+  _buf+=ref_frame_sz;
+  if(header.nrefs>1){
+    refi=_dec->state.ref_frame_idx[OC_FRAME_PREV];
+    memcpy(_buf,_dec->state.ref_frame_handle+refi*ref_frame_sz,ref_frame_sz);
+    _buf+=ref_frame_sz;
+  }
+  if(header.has_dc_qis){
+    memcpy(_buf,_dec->dc_qis,_dec->state.nfrags*sizeof(_dec->dc_qis[0]));
+  }
+}
+
+/*The snapshot frames are restored into the first two buffers, and the
+   decoder is left as th_decode_packetin() leaves it after a frame.
+  The post-processed output of the snapshot frame is not part of the snapshot,
+   so the output buffer points at the reference frame until the next coded
+   frame.*/
+static int oc_dec_snapshot_restore(oc_dec_ctx *_dec,
+ const unsigned char *_buf,size_t _buf_sz){
+  oc_dec_snapshot_header header;
+  size_t                 ref_frame_sz;
+  size_t                 sz;
+  if(_buf_sz<sizeof(header))return TH_EINVAL;
+  memcpy(&header,_buf,sizeof(header));
+  ref_frame_sz=oc_dec_ref_frame_sz(_dec);
+  if(header.ref_frame_sz!=ref_frame_sz||header.nrefs<1||header.nrefs>2){
+    return TH_EINVAL;
+  }
+  sz=sizeof(header)+header.nrefs*ref_frame_sz;
+  if(header.has_dc_qis)sz+=_dec->state.nfrags*sizeof(_dec->dc_qis[0]);
+  if(_buf_sz!=sz)return TH_EINVAL;
+  _buf+=sizeof(header);
+  if(header.has_dc_qis){
+    if(_dec->dc_qis==NULL){
+      _dec->dc_qis=(unsigned char *)_ogg_malloc(
+       _dec->state.nfrags*sizeof(_dec->dc_qis[0]));
+      if(_dec->dc_qis==NULL)return TH_EFAULT;
+    }
+    memcpy(_dec->dc_qis,_buf+header.nrefs*ref_frame_sz,
+     _dec->state.nfrags*sizeof(_dec->dc_qis[0]));
+  }
+  else{
+    _ogg_free(_dec->dc_qis);
+    _dec->dc_qis=NULL;
+  }
+  memcpy(_dec->state.ref_frame_handle,_buf,header.nrefs*ref_frame_sz);
+  _dec->state.ref_frame_idx[OC_FRAME_GOLD]=0;
+  _dec->state.ref_frame_idx[OC_FRAME_PREV]=
+   _dec->state.ref_frame_idx[OC_FRAME_SELF]=header.nrefs-1;
+  _dec->state.ref_frame_data[OC_FRAME_GOLD]=
+   _dec->state.ref_frame_bufs[0][0].data;
+  _dec->state.ref_frame_data[OC_FRAME_PREV]=
+   _dec->state.ref_frame_data[OC_FRAME_SELF]=
+   _dec->state.ref_frame_bufs[header.nrefs-1][0].data;
+  memcpy(_dec->pp_frame_buf,_dec->state.ref_frame_bufs[header.nrefs-1],
+   sizeof(_dec->pp_frame_buf[0])*3);
+  /*Force an update of the PP buffer pointers.*/
+  _dec->pp_frame_state=0;
+  _dec->state.frame_type=(signed char)header.frame_type;
+  _dec->state.granpos=header.granpos;
+  _dec->state.keyframe_num=header.keyframe_num;
+  _dec->state.curframe_num=header.curframe_num;
+  return 0;
+}
+
+/*Coded fragments are listed plane by plane, each plane's fragments numbered
+   from the bottom left, while the macro blocks are returned from the top
+   left.*/
+static void oc_dec_coded_mbs_get(const oc_dec_ctx *_dec,unsigned char *_mbs){
+  const ptrdiff_t *coded_fragis;
+  ptrdiff_t        fragii;
+  unsigned         nhmbs;
+  unsigned         nvmbs;
+  int              pli;
+  nhmbs=_dec->state.nhmbs;
+  nvmbs=_dec->state.nvmbs;
+  /*Deringing blocks that weren't coded depends on the quantizers of the
+     current frame, so the whole post-processed frame may have changed.*/
+  if(_dec->pp_level>=OC_PP_LEVEL_DERINGY&&_dec->pp_qis_changed){
+    memset(_mbs,1,nhmbs*(size_t)nvmbs);
+    return;
+  }
+  memset(_mbs,0,nhmbs*(size_t)nvmbs);
+  /*The per-plane counts are left over from the last coded frame after a
+     dropped one.*/
+  if(_dec->state.ntotal_coded_fragis<=0)return;
+  coded_fragis=_dec->state.coded_fragis;
+  fragii=0;
+  for(pli=0;pli<3;pli++){
+    const oc_fragment_plane *fplane;
+    ptrdiff_t                fragii_end;
+    int                      hshift;
+    int                      vshift;
+    fplane=_dec->state.fplanes+pli;
+    /*A macro block is two fragments wide and tall, unless the chroma plane
+       is decimated in that direction.*/
+    hshift=pli==0||(_dec->state.info.pixel_fmt&1);
+    vshift=pli==0||(_dec->state.info.pixel_fmt&2);
+    fragii_end=fragii+_dec->state.ncoded_fragis[pli];
+    for(;fragii<fragii_end;fragii++){
+      ptrdiff_t fragi;
+      unsigned  fragx;
+      unsigned  fragy;
+      fragi=coded_fragis[fragii]-fplane->froffset;
+      fragx=(unsigned)(fragi%fplane->nhfrags);
+      fragy=(unsigned)(fragi/fplane->nhfrags);
+      _mbs[(nvmbs-1-(fragy>>vshift))*(size_t)nhmbs+(fragx>>hshift)]=1;
+    }
+  }
+}
+
 void th_decode_free(th_dec_ctx *_dec){
   if(_dec!=NULL){
     oc_dec_clear(_dec);
@@ -2018,6 +2391,53 @@ int th_decode_ctl(th_dec_ctx *_dec,int _req,void *_buf,
     _dec->stripe_cb.stripe_decoded=cb->stripe_decoded;
     return 0;
   }break;
+  case TH_DECCTL_SET_THREAD_COUNT:{
+    int nthreads;
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    if(_buf_sz!=sizeof(int))return TH_EINVAL;
+    nthreads=*(int *)_buf;
+    if(nthreads<1)return TH_EINVAL;
+#if defined(OC_THREADS)
+    return oc_dec_threads_set(_dec,nthreads);
+#else
+    return nthreads>1?TH_EIMPL:0;
+#endif
+  }break;
+  case TH_DECCTL_RESET:{
+    if(_dec==NULL)return TH_EFAULT;
+    oc_dec_reset(_dec);
+    return 0;
+  }break;
+  case TH_DECCTL_GET_SNAPSHOT_SIZE:{
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    if(_buf_sz!=sizeof(size_t))return TH_EINVAL;
+    if(_dec->state.ref_frame_idx[OC_FRAME_GOLD]<0||
+     _dec->state.ref_frame_idx[OC_FRAME_PREV]<0){
+      return TH_EINVAL;
+    }
+    *(size_t *)_buf=oc_dec_snapshot_size(_dec);
+    return 0;
+  }break;
+  case TH_DECCTL_SAVE_SNAPSHOT:{
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    if(_dec->state.ref_frame_idx[OC_FRAME_GOLD]<0||
+     _dec->state.ref_frame_idx[OC_FRAME_PREV]<0||
+     _buf_sz<oc_dec_snapshot_size(_dec)){
+      return TH_EINVAL;
+    }
+    oc_dec_snapshot_save(_dec,(unsigned char *)_buf);
+    return 0;
+  }break;
+  case TH_DECCTL_RESTORE_SNAPSHOT:{
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    return oc_dec_snapshot_restore(_dec,(const unsigned char *)_buf,_buf_sz);
+  }break;
+  case TH_DECCTL_GET_CODED_MBS:{
+    if(_dec==NULL||_buf==NULL)return TH_EFAULT;
+    if(_buf_sz!=_dec->state.nhmbs*(size_t)_dec->state.nvmbs)return TH_EINVAL;
+    oc_dec_coded_mbs_get(_dec,(unsigned char *)_buf);
+    return 0;
+  }break;
 #ifdef HAVE_CAIRO
   case TH_DECCTL_SET_TELEMETRY_MBMODE:{
     if(_dec==NULL||_buf==NULL)return TH_EFAULT;
@@ -2751,11 +3171,15 @@ int th_decode_packetin(th_dec_ctx *_dec,const ogg_packet *_op,
   if(_op->bytes==0){
     _dec->state.frame_type=OC_INTER_FRAME;
     _dec->state.ntotal_coded_fragis=0;
+    _dec->pp_qis_changed=0;
   }
   else{
+    unsigned char prev_qis[3];
+    memcpy(prev_qis,_dec->state.qis,sizeof(prev_qis));
     oc_pack_readinit(&_dec->opb,_op->packet,_op->bytes);
     ret=oc_dec_frame_header_unpack(_dec);
     if(ret<0)return ret;
+    _dec->pp_qis_changed=memcmp(prev_qis,_dec->state.qis,sizeof(prev_qis))!=0;
     if(_dec->state.frame_type==OC_INTRA_FRAME)oc_dec_mark_all_intra(_dec);
     else oc_dec_coded_flags_unpack(_dec);
   }
@@ -2857,8 +3281,30 @@ int th_decode_packetin(th_dec_ctx *_dec,const ogg_packet *_op,
        in cache.*/
     oc_dec_pipeline_init(_dec,&_dec->pipe);
     oc_ycbcr_buffer_flip(stripe_buf,_dec->pp_frame_buf);
-    notstart=0;
     notdone=1;
+#if defined(OC_THREADS)
+    /*With a thread team, each color plane is reconstructed independently,
+       with its filtering stages trailing one MCU behind on another thread.
+      Telemetry rendering assumes the serial pipeline, so it disables this.*/
+# if defined(HAVE_CAIRO)
+    if(_dec->team!=NULL&&!telemetry){
+# else
+    if(_dec->team!=NULL){
+# endif
+      for(pli=0;pli<3;pli++){
+        memcpy(_dec->plane_pipes+pli,&_dec->pipe,sizeof(_dec->pipe));
+      }
+      oc_dec_team_run(_dec->team,oc_dec_team_job,_dec,6);
+      /*Only whole frames are available to the striped decode callback.*/
+      if(_dec->stripe_cb.stripe_decoded!=NULL){
+        oc_restore_fpu(&_dec->state);
+        (*_dec->stripe_cb.stripe_decoded)(_dec->stripe_cb.ctx,stripe_buf,
+         0,_dec->state.fplanes[0].nvfrags);
+      }
+      notdone=0;
+    }
+#endif
+    notstart=0;
     for(stripe_fragy=0;notdone;stripe_fragy+=_dec->pipe.mcu_nvfrags){
       int avail_fragy0;
       int avail_fragy_end;
@@ -2867,7 +3313,6 @@ int th_decode_packetin(th_dec_ctx *_dec,const ogg_packet *_op,
       for(pli=0;pli<3;pli++){
         oc_fragment_plane *fplane;
         int                frag_shift;
-        int                pp_offset;
         int                sdelay;
         int                edelay;
         fplane=_dec->state.fplanes+pli;
@@ -2879,44 +3324,9 @@ int th_decode_packetin(th_dec_ctx *_dec,const ogg_packet *_op,
          _dec->pipe.fragy0[pli]+(_dec->pipe.mcu_nvfrags>>frag_shift));
         oc_dec_dc_unpredict_mcu_plane(_dec,&_dec->pipe,pli);
         oc_dec_frags_recon_mcu_plane(_dec,&_dec->pipe,pli);
-        sdelay=edelay=0;
-        if(_dec->pipe.loop_filter){
-          sdelay+=notstart;
-          edelay+=notdone;
-          oc_state_loop_filter_frag_rows(&_dec->state,
-           _dec->pipe.bounding_values,OC_FRAME_SELF,pli,
-           _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-        }
-        /*To fill the borders, we have an additional two pixel delay, since a
-           fragment in the next row could filter its top edge, using two pixels
-           from a fragment in this row.
-          But there's no reason to delay a full fragment between the two.*/
-        oc_state_borders_fill_rows(&_dec->state,refi,pli,
-         (_dec->pipe.fragy0[pli]-sdelay<<3)-(sdelay<<1),
-         (_dec->pipe.fragy_end[pli]-edelay<<3)-(edelay<<1));
-        /*Out-of-loop post-processing.*/
-        pp_offset=3*(pli!=0);
-        if(_dec->pipe.pp_level>=OC_PP_LEVEL_DEBLOCKY+pp_offset){
-          /*Perform de-blocking in one plane.*/
-          sdelay+=notstart;
-          edelay+=notdone;
-          oc_dec_deblock_frag_rows(_dec,_dec->pp_frame_buf,
-           _dec->state.ref_frame_bufs[refi],pli,
-           _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-          if(_dec->pipe.pp_level>=OC_PP_LEVEL_DERINGY+pp_offset){
-            /*Perform de-ringing in one plane.*/
-            sdelay+=notstart;
-            edelay+=notdone;
-            oc_dec_dering_frag_rows(_dec,_dec->pp_frame_buf,pli,
-             _dec->pipe.fragy0[pli]-sdelay,_dec->pipe.fragy_end[pli]-edelay);
-          }
-        }
-        /*If no post-processing is done, we still need to delay a row for the
-           loop filter, thanks to the strange filtering order VP3 chose.*/
-        else if(_dec->pipe.loop_filter){
-          sdelay+=notstart;
-          edelay+=notdone;
-        }
+        sdelay=oc_dec_filter_mcu_plane(_dec,&_dec->pipe,refi,pli,
+         _dec->pipe.fragy0[pli],_dec->pipe.fragy_end[pli],notstart,notdone,
+         &edelay);
         /*Compute the intersection of the available rows in all planes.
           If chroma is sub-sampled, the effect of each of its delays is
            doubled, but luma might have more post-processing filters enabled
@@ -0,0 +1,169 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ogg/ogg.h>
+#include "decthread.h"
+
+#if defined(OC_THREADS)
+# if defined(_WIN32)
+#  include <process.h>
+#  define oc_mutex_init(_m)        InitializeCriticalSection(_m)
+#  define oc_mutex_clear(_m)       DeleteCriticalSection(_m)
+#  define oc_mutex_lock(_m)        EnterCriticalSection(_m)
+#  define oc_mutex_unlock(_m)      LeaveCriticalSection(_m)
+#  define oc_cond_init(_c)         InitializeConditionVariable(_c)
+#  define oc_cond_clear(_c)        do{}while(0)
+#  define oc_cond_wait(_c,_m)      SleepConditionVariableCS(_c,_m,INFINITE)
+#  define oc_cond_broadcast(_c)    WakeAllConditionVariable(_c)
+# else
+#  define oc_mutex_init(_m)        pthread_mutex_init(_m,NULL)
+#  define oc_mutex_clear(_m)       pthread_mutex_destroy(_m)
+#  define oc_mutex_lock(_m)        pthread_mutex_lock(_m)
+#  define oc_mutex_unlock(_m)      pthread_mutex_unlock(_m)
+#  define oc_cond_init(_c)         pthread_cond_init(_c,NULL)
+#  define oc_cond_clear(_c)        pthread_cond_destroy(_c)
+#  define oc_cond_wait(_c,_m)      pthread_cond_wait(_c,_m)
+#  define oc_cond_broadcast(_c)    pthread_cond_broadcast(_c)
+# endif
+
+
+
+/*Takes jobs from the current batch until there are none left.
+  The team mutex must be held on entry, and is held again on return.*/
+static void oc_dec_team_drain(oc_dec_team *_team){
+  while(_team->next_job<_team->njobs){
+    int jobi;
+    jobi=_team->next_job++;
+    oc_mutex_unlock(&_team->mutex);
+    (*_team->func)(_team->ctx,jobi);
+    oc_mutex_lock(&_team->mutex);
+    if(--_team->nremaining<=0)oc_cond_broadcast(&_team->done_cond);
+  }
+}
+
+static void oc_dec_team_work(oc_dec_team *_team){
+  oc_mutex_lock(&_team->mutex);
+  for(;;){
+    while(!_team->quit&&_team->next_job>=_team->njobs){
+      oc_cond_wait(&_team->work_cond,&_team->mutex);
+    }
+    if(_team->quit)break;
+    oc_dec_team_drain(_team);
+  }
+  oc_mutex_unlock(&_team->mutex);
+}
+
+# if defined(_WIN32)
+static unsigned __stdcall oc_dec_team_main(void *_team){
+  oc_dec_team_work((oc_dec_team *)_team);
+  return 0;
+}
+# else
+static void *oc_dec_team_main(void *_team){
+  oc_dec_team_work((oc_dec_team *)_team);
+  return NULL;
+}
+# endif
+
+int oc_dec_team_init(oc_dec_team *_team,int _nthreads){
+  int ti;
+  memset(_team,0,sizeof(*_team));
+  if(_nthreads<2)return -1;
+  _team->threads=(oc_thread *)_ogg_malloc(
+   (_nthreads-1)*sizeof(_team->threads[0]));
+  if(_team->threads==NULL)return -1;
+  oc_mutex_init(&_team->mutex);
+  oc_cond_init(&_team->work_cond);
+  oc_cond_init(&_team->done_cond);
+  oc_cond_init(&_team->progress_cond);
+  for(ti=0;ti<_nthreads-1;ti++){
+# if defined(_WIN32)
+    _team->threads[ti]=(HANDLE)_beginthreadex(NULL,0,
+     oc_dec_team_main,_team,0,NULL);
+    if(_team->threads[ti]==0)break;
+# else
+    if(pthread_create(_team->threads+ti,NULL,oc_dec_team_main,_team))break;
+# endif
+  }
+  _team->nthreads=ti+1;
+  if(ti<_nthreads-1){
+    oc_dec_team_clear(_team);
+    return -1;
+  }
+  return 0;
+}
+
+void oc_dec_team_clear(oc_dec_team *_team){
+  int ti;
+  if(_team->threads==NULL)return;
+  oc_mutex_lock(&_team->mutex);
+  _team->quit=1;
+  oc_cond_broadcast(&_team->work_cond);
+  oc_mutex_unlock(&_team->mutex);
+  for(ti=0;ti<_team->nthreads-1;ti++){
+# if defined(_WIN32)
+    WaitForSingleObject(_team->threads[ti],INFINITE);
+    CloseHandle(_team->threads[ti]);
+# else
+    pthread_join(_team->threads[ti],NULL);
+# endif
+  }
+  oc_cond_clear(&_team->progress_cond);
+  oc_cond_clear(&_team->done_cond);
+  oc_cond_clear(&_team->work_cond);
+  oc_mutex_clear(&_team->mutex);
+  _ogg_free(_team->threads);
+  _team->threads=NULL;
+  _team->nthreads=0;
+}
+
+void oc_dec_team_run(oc_dec_team *_team,oc_dec_team_func _func,void *_ctx,
+ int _njobs){
+  oc_mutex_lock(&_team->mutex);
+  memset(_team->progress,0,sizeof(_team->progress));
+  _team->func=_func;
+  _team->ctx=_ctx;
+  _team->next_job=0;
+  _team->njobs=_njobs;
+  _team->nremaining=_njobs;
+  oc_cond_broadcast(&_team->work_cond);
+  oc_dec_team_drain(_team);
+  while(_team->nremaining>0)oc_cond_wait(&_team->done_cond,&_team->mutex);
+  /*Leave the batch looking exhausted so woken workers go back to sleep.*/
+  _team->njobs=0;
+  _team->next_job=0;
+  oc_mutex_unlock(&_team->mutex);
+}
+
+void oc_dec_team_progress_set(oc_dec_team *_team,int _idx,int _value){
+  oc_mutex_lock(&_team->mutex);
+  _team->progress[_idx]=_value;
+  oc_cond_broadcast(&_team->progress_cond);
+  oc_mutex_unlock(&_team->mutex);
+}
+
+void oc_dec_team_progress_wait(oc_dec_team *_team,int _idx,int _value){
+  oc_mutex_lock(&_team->mutex);
+  while(_team->progress[_idx]<_value){
+    oc_cond_wait(&_team->progress_cond,&_team->mutex);
+  }
+  oc_mutex_unlock(&_team->mutex);
+}
+
+#endif
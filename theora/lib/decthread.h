@@ -0,0 +1,90 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+#if !defined(_decthread_H)
+# define _decthread_H (1)
+
+/*Threaded reconstruction is available wherever we know how to spawn threads,
+   unless it has been explicitly disabled.*/
+# if !defined(OC_THREADS)&&!defined(OC_DISABLE_THREADS)
+#  if defined(_WIN32)||defined(__unix__)||defined(__APPLE__)
+#   define OC_THREADS (1)
+#  endif
+# endif
+
+# if defined(OC_THREADS)
+#  if defined(_WIN32)
+#   include <windows.h>
+typedef CRITICAL_SECTION   oc_mutex;
+typedef CONDITION_VARIABLE oc_cond;
+typedef HANDLE             oc_thread;
+#  else
+#   include <pthread.h>
+typedef pthread_mutex_t    oc_mutex;
+typedef pthread_cond_t     oc_cond;
+typedef pthread_t          oc_thread;
+#  endif
+
+typedef struct oc_dec_team oc_dec_team;
+
+/*A job run by the thread team.
+  _ctx:  The context pointer passed to oc_dec_team_run().
+  _jobi: The index of the job in the current batch.*/
+typedef void (*oc_dec_team_func)(void *_ctx,int _jobi);
+
+/*The maximum number of progress counters available to a batch.*/
+# define OC_DEC_TEAM_NPROGRESS (3)
+
+/*A small pool of worker threads that cooperatively run a batch of jobs.
+  Jobs are handed out strictly in index order, and the thread that submits a
+   batch also runs jobs until the batch is exhausted.
+  A job may block on a progress counter published by a job with a lower index;
+   since that job was necessarily started first and never blocks on a later
+   one, this can not deadlock regardless of the number of threads.*/
+struct oc_dec_team{
+  oc_mutex          mutex;
+  /*Signaled when a new batch is posted or the team is shutting down.*/
+  oc_cond           work_cond;
+  /*Signaled when the last job of a batch has finished.*/
+  oc_cond           done_cond;
+  /*Signaled whenever a progress counter advances.*/
+  oc_cond           progress_cond;
+  oc_thread        *threads;
+  int               nthreads;
+  oc_dec_team_func  func;
+  void             *ctx;
+  int               njobs;
+  int               next_job;
+  int               nremaining;
+  int               quit;
+  int               progress[OC_DEC_TEAM_NPROGRESS];
+};
+
+/*Starts _nthreads-1 worker threads (the caller is the remaining one).
+  Return: 0 on success, or a negative value on failure.*/
+int oc_dec_team_init(oc_dec_team *_team,int _nthreads);
+void oc_dec_team_clear(oc_dec_team *_team);
+/*Runs jobs 0..._njobs-1 across the team and returns when all have finished.
+  All progress counters are reset to zero before the first job starts.*/
+void oc_dec_team_run(oc_dec_team *_team,oc_dec_team_func _func,void *_ctx,
+ int _njobs);
+/*Publishes a new value for a (monotonically increasing) progress counter.*/
+void oc_dec_team_progress_set(oc_dec_team *_team,int _idx,int _value);
+/*Blocks until a progress counter reaches at least _value.*/
+void oc_dec_team_progress_wait(oc_dec_team *_team,int _idx,int _value);
+
+# endif
+#endif
@@ -0,0 +1,554 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+/*SSE2 acceleration of the decoder's out-of-loop post-processing filters.
+  All of these produce output identical to the C versions in decode.c.*/
+#include <string.h>
+#include "x86dec.h"
+
+#if defined(OC_X86_ASM)
+
+/*Neither filter looks at the actual value of a sum past 1020 (4*255), nor at
+   a difference past 255, so larger thresholds can be clamped to fit in 16
+   bits without changing the result.*/
+#define OC_PP_THRESH_MAX (1024)
+
+
+
+/*Converts the 8x8 block of bytes given by the 8 row addresses into columns.
+  On exit, xmm0={c0,c1}, xmm1={c2,c3}, xmm4={c4,c5}, and xmm3={c6,c7}, where
+   each c_i occupies one quadword.
+  xmm2 and xmm5 are clobbered.*/
+#define OC_PP_TRANSPOSE8x8B_SSE2(_l0,_l1,_l2,_l3,_l4,_l5,_l6,_l7) \
+  "#OC_PP_TRANSPOSE8x8B_SSE2\n\t" \
+  "movq "_l0",%%xmm0\n\t" \
+  "movq "_l1",%%xmm4\n\t" \
+  "movq "_l2",%%xmm1\n\t" \
+  "movq "_l3",%%xmm5\n\t" \
+  "punpcklbw %%xmm4,%%xmm0\n\t" \
+  "punpcklbw %%xmm5,%%xmm1\n\t" \
+  "movq "_l4",%%xmm2\n\t" \
+  "movq "_l5",%%xmm4\n\t" \
+  "movq "_l6",%%xmm3\n\t" \
+  "movq "_l7",%%xmm5\n\t" \
+  "punpcklbw %%xmm4,%%xmm2\n\t" \
+  "punpcklbw %%xmm5,%%xmm3\n\t" \
+  "movdqa %%xmm0,%%xmm4\n\t" \
+  "punpcklwd %%xmm1,%%xmm0\n\t" \
+  "punpckhwd %%xmm1,%%xmm4\n\t" \
+  "movdqa %%xmm2,%%xmm5\n\t" \
+  "punpcklwd %%xmm3,%%xmm2\n\t" \
+  "punpckhwd %%xmm3,%%xmm5\n\t" \
+  "movdqa %%xmm0,%%xmm1\n\t" \
+  "punpckldq %%xmm2,%%xmm0\n\t" \
+  "punpckhdq %%xmm2,%%xmm1\n\t" \
+  "movdqa %%xmm4,%%xmm3\n\t" \
+  "punpckldq %%xmm5,%%xmm4\n\t" \
+  "punpckhdq %%xmm5,%%xmm3\n\t" \
+
+/*Expands the two columns of bytes in _reg to words and stores them at _offs0
+   and _offs1 in %[r].
+  xmm7 must be zero; xmm6 is clobbered.*/
+#define OC_PP_STORE_COLS_SSE2(_reg,_offs0,_offs1) \
+  "movdqa %%xmm"_reg",%%xmm6\n\t" \
+  "punpcklbw %%xmm7,%%xmm"_reg"\n\t" \
+  "punpckhbw %%xmm7,%%xmm6\n\t" \
+  "movdqa %%xmm"_reg","OC_MEM_OFFS(_offs0,r)"\n\t" \
+  "movdqa %%xmm6,"OC_MEM_OFFS(_offs1,r)"\n\t" \
+
+/*Loads the next row of bytes from %[src] into xmm1, expands the current one
+   in xmm0 to words and stores it at _offs in %[r], and makes the new row
+   current.
+  xmm7 must be zero.*/
+#define OC_PP_LOAD_ROW_SSE2(_offs) \
+  "movq (%[src]),%%xmm1\n\t" \
+  "punpcklbw %%xmm7,%%xmm0\n\t" \
+  "add %[src_ystride],%[src]\n\t" \
+  "movdqa %%xmm0,"OC_MEM_OFFS(_offs,r)"\n\t" \
+  "movdqa %%xmm1,%%xmm0\n\t" \
+
+/*xmm_reg=abs(r_a-r_b), where r_a and r_b are the rows of words at _offsa and
+   _offsb in %[r].
+  xmm3 is clobbered.*/
+#define OC_PP_ABSDIFF_SSE2(_offsa,_offsb,_reg) \
+  "movdqa "OC_MEM_OFFS(_offsa,r)",%%xmm"_reg"\n\t" \
+  "movdqa "OC_MEM_OFFS(_offsb,r)",%%xmm3\n\t" \
+  "psubusw "OC_MEM_OFFS(_offsb,r)",%%xmm"_reg"\n\t" \
+  "psubusw "OC_MEM_OFFS(_offsa,r)",%%xmm3\n\t" \
+  "por %%xmm3,%%xmm"_reg"\n\t" \
+
+/*Computes the activity measures and filter decision for the 10 rows of words
+   r0...r9 in %[r], where the edge being filtered lies between r4 and r5.
+  The clamped activity on either side, summed across all 8 lanes, is stored
+   in the first word of each half of %[sums].
+  On exit, xmm6 holds the mask of lanes to filter, xmm5 holds the first sum of
+   the 7-tap window used to filter them, and xmm7={4}x8.*/
+#define OC_PP_EDGE_MASK_SSE2 \
+  "#OC_PP_EDGE_MASK_SSE2\n\t" \
+  /*xmm5=sum0=abs(r1-r0)+abs(r2-r1)+abs(r3-r2)+abs(r4-r3)*/ \
+  OC_PP_ABSDIFF_SSE2(0x00,0x10,"5") \
+  OC_PP_ABSDIFF_SSE2(0x10,0x20,"2") \
+  "paddw %%xmm2,%%xmm5\n\t" \
+  OC_PP_ABSDIFF_SSE2(0x20,0x30,"2") \
+  "paddw %%xmm2,%%xmm5\n\t" \
+  OC_PP_ABSDIFF_SSE2(0x30,0x40,"2") \
+  "paddw %%xmm2,%%xmm5\n\t" \
+  /*xmm4=abs(r5-r4)*/ \
+  OC_PP_ABSDIFF_SSE2(0x40,0x50,"4") \
+  /*xmm6=sum1=abs(r5-r6)+abs(r6-r7)+abs(r7-r8)+abs(r8-r9)*/ \
+  OC_PP_ABSDIFF_SSE2(0x50,0x60,"6") \
+  OC_PP_ABSDIFF_SSE2(0x60,0x70,"2") \
+  "paddw %%xmm2,%%xmm6\n\t" \
+  OC_PP_ABSDIFF_SSE2(0x70,0x80,"2") \
+  "paddw %%xmm2,%%xmm6\n\t" \
+  OC_PP_ABSDIFF_SSE2(0x80,0x90,"2") \
+  "paddw %%xmm2,%%xmm6\n\t" \
+  /*Packing with unsigned saturation clamps each sum to 255, and psadbw then \
+     adds up each half.*/ \
+  "movdqa %%xmm5,%%xmm0\n\t" \
+  "pxor %%xmm7,%%xmm7\n\t" \
+  "packuswb %%xmm6,%%xmm0\n\t" \
+  "psadbw %%xmm7,%%xmm0\n\t" \
+  "movdqa %%xmm0,%[sums]\n\t" \
+  /*xmm6=sum0<flimit&&sum1<flimit&&abs(r5-r4)<qstep*/ \
+  "movd %[flimit],%%xmm1\n\t" \
+  "pshuflw $0x00,%%xmm1,%%xmm1\n\t" \
+  "punpcklqdq %%xmm1,%%xmm1\n\t" \
+  "movdqa %%xmm1,%%xmm2\n\t" \
+  "pcmpgtw %%xmm5,%%xmm1\n\t" \
+  "pcmpgtw %%xmm6,%%xmm2\n\t" \
+  "movd %[qstep],%%xmm3\n\t" \
+  "pshuflw $0x00,%%xmm3,%%xmm3\n\t" \
+  "punpcklqdq %%xmm3,%%xmm3\n\t" \
+  "pcmpgtw %%xmm4,%%xmm3\n\t" \
+  "pand %%xmm2,%%xmm1\n\t" \
+  "pand %%xmm3,%%xmm1\n\t" \
+  "movdqa %%xmm1,%%xmm6\n\t" \
+  /*Every output is the sum of a 7-tap window centered on the pixel (with the \
+     end rows replicated), plus the pixel itself. \
+    xmm5=3*r0+r1+r2+r3+r4, the window for the first output.*/ \
+  "movdqa "OC_MEM_OFFS(0x00,r)",%%xmm5\n\t" \
+  "paddw %%xmm5,%%xmm5\n\t" \
+  "paddw "OC_MEM_OFFS(0x00,r)",%%xmm5\n\t" \
+  "paddw "OC_MEM_OFFS(0x10,r)",%%xmm5\n\t" \
+  "paddw "OC_MEM_OFFS(0x20,r)",%%xmm5\n\t" \
+  "paddw "OC_MEM_OFFS(0x30,r)",%%xmm5\n\t" \
+  "paddw "OC_MEM_OFFS(0x40,r)",%%xmm5\n\t" \
+  /*xmm7={4}x8*/ \
+  "pcmpeqw %%xmm7,%%xmm7\n\t" \
+  "psrlw $15,%%xmm7\n\t" \
+  "psllw $2,%%xmm7\n\t" \
+
+/*Computes the output for the row of words at _offs in %[r], selecting either
+   the filtered or the original value according to the mask in xmm6, and
+   leaves it packed into the low 8 bytes of xmm0.
+  xmm1 is clobbered.*/
+#define OC_PP_EDGE_OUT_SSE2(_offs) \
+  "movdqa %%xmm5,%%xmm0\n\t" \
+  "paddw "OC_MEM_OFFS(_offs,r)",%%xmm0\n\t" \
+  "movdqa %%xmm6,%%xmm1\n\t" \
+  "paddw %%xmm7,%%xmm0\n\t" \
+  "pandn "OC_MEM_OFFS(_offs,r)",%%xmm1\n\t" \
+  "psrlw $3,%%xmm0\n\t" \
+  "pand %%xmm6,%%xmm0\n\t" \
+  "por %%xmm1,%%xmm0\n\t" \
+  "packuswb %%xmm0,%%xmm0\n\t" \
+
+/*Slides the 7-tap window in xmm5 down by one row.*/
+#define OC_PP_EDGE_SLIDE_SSE2(_offs_out,_offs_in) \
+  "paddw "OC_MEM_OFFS(_offs_in,r)",%%xmm5\n\t" \
+  "psubw "OC_MEM_OFFS(_offs_out,r)",%%xmm5\n\t" \
+
+#define OC_PP_HEDGE_STORE_SSE2 \
+  "movq %%xmm0,(%[dst])\n\t" \
+  "add %[dst_ystride],%[dst]\n\t" \
+
+#define OC_PP_VEDGE_STORE_SSE2(_offs) \
+  "movq %%xmm0,"OC_MEM_OFFS(_offs,o)"\n\t" \
+
+/*Filter a horizontal block edge.
+  Each of the 8 columns is handled in its own 16-bit lane.*/
+void oc_filter_hedge_sse2(unsigned char *_dst,int _dst_ystride,
+ const unsigned char *_src,int _src_ystride,int _qstep,int _flimit,
+ int *_variance0,int *_variance1){
+  OC_ALIGN16(ogg_int16_t  r[80]);
+  OC_ALIGN16(ogg_uint16_t sums[8]);
+  ptrdiff_t src_ystride;
+  ptrdiff_t dst_ystride;
+  src_ystride=_src_ystride;
+  dst_ystride=_dst_ystride;
+  _qstep=OC_MINI(_qstep,OC_PP_THRESH_MAX);
+  _flimit=OC_MINI(_flimit,OC_PP_THRESH_MAX);
+  __asm__ __volatile__(
+    "pxor %%xmm7,%%xmm7\n\t"
+    "movq (%[src]),%%xmm0\n\t"
+    "add %[src_ystride],%[src]\n\t"
+    OC_PP_LOAD_ROW_SSE2(0x00)
+    OC_PP_LOAD_ROW_SSE2(0x10)
+    OC_PP_LOAD_ROW_SSE2(0x20)
+    OC_PP_LOAD_ROW_SSE2(0x30)
+    OC_PP_LOAD_ROW_SSE2(0x40)
+    OC_PP_LOAD_ROW_SSE2(0x50)
+    OC_PP_LOAD_ROW_SSE2(0x60)
+    OC_PP_LOAD_ROW_SSE2(0x70)
+    OC_PP_LOAD_ROW_SSE2(0x80)
+    "punpcklbw %%xmm7,%%xmm0\n\t"
+    "movdqa %%xmm0,"OC_MEM_OFFS(0x90,r)"\n\t"
+    :[src]"+r"(_src),[r]"=m"(OC_ARRAY_OPERAND(ogg_int16_t,r,80))
+    :[src_ystride]"r"(src_ystride)
+  );
+  __asm__ __volatile__(
+    OC_PP_EDGE_MASK_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x10)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x50)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x20)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x60)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x30)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x70)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x40)
+    OC_PP_EDGE_SLIDE_SSE2(0x10,0x80)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x50)
+    OC_PP_EDGE_SLIDE_SSE2(0x20,0x90)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x60)
+    OC_PP_EDGE_SLIDE_SSE2(0x30,0x90)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x70)
+    OC_PP_EDGE_SLIDE_SSE2(0x40,0x90)
+    OC_PP_HEDGE_STORE_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x80)
+    OC_PP_HEDGE_STORE_SSE2
+    :[dst]"+r"(_dst),[sums]"=m"(OC_ARRAY_OPERAND(ogg_uint16_t,sums,8))
+    :[r]"m"(OC_CONST_ARRAY_OPERAND(ogg_int16_t,r,80)),
+     [dst_ystride]"r"(dst_ystride),[flimit]"r"(_flimit),[qstep]"r"(_qstep)
+    :"memory"
+  );
+  *_variance0+=sums[0];
+  *_variance1+=sums[4];
+}
+
+/*Filter a vertical block edge.
+  The block is transposed so that each of the 8 rows is handled in its own
+   16-bit lane, and then transposed back.*/
+void oc_filter_vedge_sse2(unsigned char *_dst,int _dst_ystride,
+ int _qstep,int _flimit,int *_variances){
+  OC_ALIGN16(ogg_int16_t   r[80]);
+  OC_ALIGN16(unsigned char o[64]);
+  OC_ALIGN16(ogg_uint16_t  sums[8]);
+  const unsigned char *src;
+  const unsigned char *src4;
+  ptrdiff_t            ystride;
+  ptrdiff_t            ystride3;
+  ystride=_dst_ystride;
+  ystride3=3*ystride;
+  _qstep=OC_MINI(_qstep,OC_PP_THRESH_MAX);
+  _flimit=OC_MINI(_flimit,OC_PP_THRESH_MAX);
+  /*Columns 0...7.*/
+  src=_dst-1;
+  src4=src+(ystride<<2);
+  __asm__ __volatile__(
+    "pxor %%xmm7,%%xmm7\n\t"
+    OC_PP_TRANSPOSE8x8B_SSE2("(%[src])","(%[src],%[ystride])",
+     "(%[src],%[ystride],2)","(%[src],%[ystride3])","(%[src4])",
+     "(%[src4],%[ystride])","(%[src4],%[ystride],2)","(%[src4],%[ystride3])")
+    OC_PP_STORE_COLS_SSE2("0",0x00,0x10)
+    OC_PP_STORE_COLS_SSE2("1",0x20,0x30)
+    OC_PP_STORE_COLS_SSE2("4",0x40,0x50)
+    OC_PP_STORE_COLS_SSE2("3",0x60,0x70)
+    :[r]"=m"(OC_ARRAY_OPERAND(ogg_int16_t,r,80))
+    :[src]"r"(src),[src4]"r"(src4),
+     [ystride]"r"(ystride),[ystride3]"r"(ystride3)
+  );
+  /*Columns 8 and 9, without reading past the last one.*/
+  src+=2;
+  src4+=2;
+  __asm__ __volatile__(
+    "pxor %%xmm7,%%xmm7\n\t"
+    OC_PP_TRANSPOSE8x8B_SSE2("(%[src])","(%[src],%[ystride])",
+     "(%[src],%[ystride],2)","(%[src],%[ystride3])","(%[src4])",
+     "(%[src4],%[ystride])","(%[src4],%[ystride],2)","(%[src4],%[ystride3])")
+    OC_PP_STORE_COLS_SSE2("3",0x80,0x90)
+    :[r]"+m"(OC_ARRAY_OPERAND(ogg_int16_t,r,80))
+    :[src]"r"(src),[src4]"r"(src4),
+     [ystride]"r"(ystride),[ystride3]"r"(ystride3)
+  );
+  __asm__ __volatile__(
+    OC_PP_EDGE_MASK_SSE2
+    OC_PP_EDGE_OUT_SSE2(0x10)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x50)
+    OC_PP_VEDGE_STORE_SSE2(0x00)
+    OC_PP_EDGE_OUT_SSE2(0x20)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x60)
+    OC_PP_VEDGE_STORE_SSE2(0x08)
+    OC_PP_EDGE_OUT_SSE2(0x30)
+    OC_PP_EDGE_SLIDE_SSE2(0x00,0x70)
+    OC_PP_VEDGE_STORE_SSE2(0x10)
+    OC_PP_EDGE_OUT_SSE2(0x40)
+    OC_PP_EDGE_SLIDE_SSE2(0x10,0x80)
+    OC_PP_VEDGE_STORE_SSE2(0x18)
+    OC_PP_EDGE_OUT_SSE2(0x50)
+    OC_PP_EDGE_SLIDE_SSE2(0x20,0x90)
+    OC_PP_VEDGE_STORE_SSE2(0x20)
+    OC_PP_EDGE_OUT_SSE2(0x60)
+    OC_PP_EDGE_SLIDE_SSE2(0x30,0x90)
+    OC_PP_VEDGE_STORE_SSE2(0x28)
+    OC_PP_EDGE_OUT_SSE2(0x70)
+    OC_PP_EDGE_SLIDE_SSE2(0x40,0x90)
+    OC_PP_VEDGE_STORE_SSE2(0x30)
+    OC_PP_EDGE_OUT_SSE2(0x80)
+    OC_PP_VEDGE_STORE_SSE2(0x38)
+    :[o]"=m"(OC_ARRAY_OPERAND(unsigned char,o,64)),
+     [sums]"=m"(OC_ARRAY_OPERAND(ogg_uint16_t,sums,8))
+    :[r]"m"(OC_CONST_ARRAY_OPERAND(ogg_int16_t,r,80)),
+     [flimit]"r"(_flimit),[qstep]"r"(_qstep)
+  );
+  /*Transpose back and write the 8 rows, unfiltered lanes included, since they
+     just reproduce the original pixels.*/
+  src4=_dst+(ystride<<2);
+  __asm__ __volatile__(
+    OC_PP_TRANSPOSE8x8B_SSE2(OC_MEM_OFFS(0x00,o),OC_MEM_OFFS(0x08,o),
+     OC_MEM_OFFS(0x10,o),OC_MEM_OFFS(0x18,o),OC_MEM_OFFS(0x20,o),
+     OC_MEM_OFFS(0x28,o),OC_MEM_OFFS(0x30,o),OC_MEM_OFFS(0x38,o))
+    "movq %%xmm0,(%[dst])\n\t"
+    "movhps %%xmm0,(%[dst],%[ystride])\n\t"
+    "movq %%xmm1,(%[dst],%[ystride],2)\n\t"
+    "movhps %%xmm1,(%[dst],%[ystride3])\n\t"
+    "movq %%xmm4,(%[dst4])\n\t"
+    "movhps %%xmm4,(%[dst4],%[ystride])\n\t"
+    "movq %%xmm3,(%[dst4],%[ystride],2)\n\t"
+    "movhps %%xmm3,(%[dst4],%[ystride3])\n\t"
+    :
+    :[o]"m"(OC_CONST_ARRAY_OPERAND(unsigned char,o,64)),
+     [dst]"r"(_dst),[dst4]"r"(src4),
+     [ystride]"r"(ystride),[ystride3]"r"(ystride3)
+    :"memory"
+  );
+  _variances[0]+=sums[0];
+  _variances[1]+=sums[4];
+}
+
+
+
+/*Constants used by oc_dering_block_sse2().*/
+static const ogg_int16_t __attribute__((aligned(16),used))
+ OC_DERING_CONSTS_SSE2[24]={
+  128,128,128,128,128,128,128,128,
+   64, 64, 64, 64, 64, 64, 64, 64,
+    1,  1,  1,  1,  1,  1,  1,  1
+};
+
+/*Computes a row of 8 filter weights from the absolute differences between
+   the rows of bytes at _offsa and _offsb in %[pix], and stores them at _offs
+   in the array _name.
+  On entry, xmm3 must hold the shift applied to the differences, xmm4, xmm5,
+   and xmm6 must hold 32+dc_scale, mod_hi, and sharp_mod in each lane, and
+   xmm7 must be zero.
+  xmm0...xmm2 are clobbered.*/
+#define OC_DERING_MOD_SSE2(_offsa,_offsb,_offs,_name) \
+  "movq "OC_MEM_OFFS(_offsa,pix)",%%xmm0\n\t" \
+  "movq "OC_MEM_OFFS(_offsb,pix)",%%xmm1\n\t" \
+  "movdqa %%xmm0,%%xmm2\n\t" \
+  "psubusb %%xmm1,%%xmm0\n\t" \
+  "psubusb %%xmm2,%%xmm1\n\t" \
+  "por %%xmm1,%%xmm0\n\t" \
+  "punpcklbw %%xmm7,%%xmm0\n\t" \
+  /*xmm1=mod=32+dc_scale-(abs(a-b)<<shift)*/ \
+  "psllw %%xmm3,%%xmm0\n\t" \
+  "movdqa %%xmm4,%%xmm1\n\t" \
+  "psubw %%xmm0,%%xmm1\n\t" \
+  /*xmm2=mod<-64*/ \
+  "pcmpeqw %%xmm2,%%xmm2\n\t" \
+  "psllw $6,%%xmm2\n\t" \
+  "pcmpgtw %%xmm1,%%xmm2\n\t" \
+  /*xmm0=mod<-64?sharp_mod:OC_CLAMPI(0,mod,mod_hi)*/ \
+  "pminsw %%xmm5,%%xmm1\n\t" \
+  "pmaxsw %%xmm7,%%xmm1\n\t" \
+  "movdqa %%xmm6,%%xmm0\n\t" \
+  "pand %%xmm2,%%xmm0\n\t" \
+  "pandn %%xmm1,%%xmm2\n\t" \
+  "por %%xmm2,%%xmm0\n\t" \
+  "movdqa %%xmm0,"OC_MEM_OFFS(_offs,_name)"\n\t" \
+
+/*Computes the part of the filter output for one row that does not depend on
+   any previously filtered pixel:
+    (128-hl-hr-vu-vd)*c+vd*down+hr*right+64,
+   where c, down, and right are the rows of bytes at _offsc, _offsd, and
+   _offsr in %[pix], vu and vd are the rows of weights at _offsvu and _offsvd
+   in %[vmod], and hl and hr are the rows of weights at _offshl and _offshr in
+   %[hmod].
+  The 8 32-bit results are stored at _offsp in %[p].
+  xmm7 must be zero; xmm0...xmm6 are clobbered.*/
+#define OC_DERING_ROW_SSE2(_offsc,_offsd,_offsr,_offsvu,_offsvd, \
+ _offshl,_offshr,_offsp) \
+  "movq "OC_MEM_OFFS(_offsc,pix)",%%xmm0\n\t" \
+  "movq "OC_MEM_OFFS(_offsd,pix)",%%xmm1\n\t" \
+  "movq "OC_MEM_OFFS(_offsr,pix)",%%xmm2\n\t" \
+  "punpcklbw %%xmm7,%%xmm0\n\t" \
+  "punpcklbw %%xmm7,%%xmm1\n\t" \
+  "punpcklbw %%xmm7,%%xmm2\n\t" \
+  /*xmm3=a=128-hl-hr-vu-vd*/ \
+  "movdqa (%[c]),%%xmm3\n\t" \
+  "movdqa "OC_MEM_OFFS(_offsvd,vmod)",%%xmm4\n\t" \
+  "psubw "OC_MEM_OFFS(_offshl,hmod)",%%xmm3\n\t" \
+  "psubw "OC_MEM_OFFS(_offshr,hmod)",%%xmm3\n\t" \
+  "psubw "OC_MEM_OFFS(_offsvu,vmod)",%%xmm3\n\t" \
+  "psubw %%xmm4,%%xmm3\n\t" \
+  /*xmm5:xmm3={a,vd}.{c,down}*/ \
+  "movdqa %%xmm3,%%xmm5\n\t" \
+  "punpcklwd %%xmm4,%%xmm3\n\t" \
+  "punpckhwd %%xmm4,%%xmm5\n\t" \
+  "movdqa %%xmm0,%%xmm6\n\t" \
+  "punpcklwd %%xmm1,%%xmm0\n\t" \
+  "punpckhwd %%xmm1,%%xmm6\n\t" \
+  "pmaddwd %%xmm0,%%xmm3\n\t" \
+  "pmaddwd %%xmm6,%%xmm5\n\t" \
+  /*xmm6:xmm4={hr,64}.{right,1}*/ \
+  "movdqa "OC_MEM_OFFS(_offshr,hmod)",%%xmm4\n\t" \
+  "movdqa 0x10(%[c]),%%xmm1\n\t" \
+  "movdqa %%xmm4,%%xmm6\n\t" \
+  "punpcklwd %%xmm1,%%xmm4\n\t" \
+  "punpckhwd %%xmm1,%%xmm6\n\t" \
+  "movdqa 0x20(%[c]),%%xmm1\n\t" \
+  "movdqa %%xmm2,%%xmm0\n\t" \
+  "punpcklwd %%xmm1,%%xmm2\n\t" \
+  "punpckhwd %%xmm1,%%xmm0\n\t" \
+  "pmaddwd %%xmm2,%%xmm4\n\t" \
+  "pmaddwd %%xmm0,%%xmm6\n\t" \
+  "paddd %%xmm4,%%xmm3\n\t" \
+  "paddd %%xmm6,%%xmm5\n\t" \
+  "movdqa %%xmm3,"OC_MEM_OFFS(_offsp,p)"\n\t" \
+  "movdqa %%xmm5,"OC_MEM_OFFS(_offsp+0x10,p)"\n\t" \
+
+/*Copies a row of the block into the padded working copy, replicating the
+   edge pixels where the block lies on the left or right side of the plane.*/
+static void oc_dering_pad_row(unsigned char _dst[16],
+ const unsigned char *_src,int _b){
+  _dst[0]=_src[-!(_b&1)];
+  memcpy(_dst+1,_src,8);
+  _dst[9]=_src[7+!(_b&2)];
+}
+
+/*De-ring an 8x8 block.
+  Each output pixel depends on the already filtered pixels to its left and
+   above, so the filter itself must run serially.
+  However, all of the weights, and the terms involving unfiltered pixels, can
+   be computed in parallel beforehand, which leaves very little for the serial
+   part to do.*/
+void oc_dering_block_sse2(unsigned char *_idata,int _ystride,int _b,
+ int _dc_scale,int _sharp_mod,int _strong){
+  static const unsigned char OC_MOD_MAX[2]={24,32};
+  static const unsigned char OC_MOD_SHIFT[2]={1,0};
+  /*The block with a one pixel border on each side, one row per 16 bytes.*/
+  OC_ALIGN16(unsigned char pix[160]);
+  /*The vertical weights: row by applies between rows by-1 and by.*/
+  OC_ALIGN16(ogg_int16_t   vmod[72]);
+  /*The horizontal weights: for each row, the weights applied to the left
+     neighbors followed by the weights applied to the right neighbors.*/
+  OC_ALIGN16(ogg_int16_t   hmod[128]);
+  OC_ALIGN16(ogg_int32_t   p[64]);
+  const unsigned char *psrc;
+  unsigned char       *dst;
+  int                  mod_hi;
+  int                  by;
+  int                  bx;
+  mod_hi=OC_MINI(3*_dc_scale,OC_MOD_MAX[_strong]);
+  psrc=_idata-(_ystride&-!(_b&4));
+  oc_dering_pad_row(pix,psrc,_b);
+  for(by=0;by<8;by++)oc_dering_pad_row(pix+(by+1<<4),_idata+by*_ystride,_b);
+  oc_dering_pad_row(pix+144,_idata+(7+!(_b&8))*_ystride,_b);
+  __asm__ __volatile__(
+    "movd %[k],%%xmm4\n\t"
+    "pshuflw $0x00,%%xmm4,%%xmm4\n\t"
+    "punpcklqdq %%xmm4,%%xmm4\n\t"
+    "movd %[mod_hi],%%xmm5\n\t"
+    "pshuflw $0x00,%%xmm5,%%xmm5\n\t"
+    "punpcklqdq %%xmm5,%%xmm5\n\t"
+    "movd %[sharp_mod],%%xmm6\n\t"
+    "pshuflw $0x00,%%xmm6,%%xmm6\n\t"
+    "punpcklqdq %%xmm6,%%xmm6\n\t"
+    "movd %[shift],%%xmm3\n\t"
+    "pxor %%xmm7,%%xmm7\n\t"
+    OC_DERING_MOD_SSE2(0x01,0x11,0x00,vmod)
+    OC_DERING_MOD_SSE2(0x11,0x21,0x10,vmod)
+    OC_DERING_MOD_SSE2(0x21,0x31,0x20,vmod)
+    OC_DERING_MOD_SSE2(0x31,0x41,0x30,vmod)
+    OC_DERING_MOD_SSE2(0x41,0x51,0x40,vmod)
+    OC_DERING_MOD_SSE2(0x51,0x61,0x50,vmod)
+    OC_DERING_MOD_SSE2(0x61,0x71,0x60,vmod)
+    OC_DERING_MOD_SSE2(0x71,0x81,0x70,vmod)
+    OC_DERING_MOD_SSE2(0x81,0x91,0x80,vmod)
+    OC_DERING_MOD_SSE2(0x10,0x11,0x00,hmod)
+    OC_DERING_MOD_SSE2(0x11,0x12,0x10,hmod)
+    OC_DERING_MOD_SSE2(0x20,0x21,0x20,hmod)
+    OC_DERING_MOD_SSE2(0x21,0x22,0x30,hmod)
+    OC_DERING_MOD_SSE2(0x30,0x31,0x40,hmod)
+    OC_DERING_MOD_SSE2(0x31,0x32,0x50,hmod)
+    OC_DERING_MOD_SSE2(0x40,0x41,0x60,hmod)
+    OC_DERING_MOD_SSE2(0x41,0x42,0x70,hmod)
+    OC_DERING_MOD_SSE2(0x50,0x51,0x80,hmod)
+    OC_DERING_MOD_SSE2(0x51,0x52,0x90,hmod)
+    OC_DERING_MOD_SSE2(0x60,0x61,0xA0,hmod)
+    OC_DERING_MOD_SSE2(0x61,0x62,0xB0,hmod)
+    OC_DERING_MOD_SSE2(0x70,0x71,0xC0,hmod)
+    OC_DERING_MOD_SSE2(0x71,0x72,0xD0,hmod)
+    OC_DERING_MOD_SSE2(0x80,0x81,0xE0,hmod)
+    OC_DERING_MOD_SSE2(0x81,0x82,0xF0,hmod)
+    :[vmod]"=m"(OC_ARRAY_OPERAND(ogg_int16_t,vmod,72)),
+     [hmod]"=m"(OC_ARRAY_OPERAND(ogg_int16_t,hmod,128))
+    :[pix]"m"(OC_CONST_ARRAY_OPERAND(unsigned char,pix,160)),
+     /*Past this point mod is at least mod_hi no matter what the difference,
+        so clamping dc_scale keeps everything in 16 bits.*/
+     [k]"r"(32+OC_MINI(_dc_scale,OC_PP_THRESH_MAX)),[mod_hi]"r"(mod_hi),
+     [sharp_mod]"r"(_sharp_mod),[shift]"r"((int)OC_MOD_SHIFT[_strong])
+  );
+  __asm__ __volatile__(
+    "pxor %%xmm7,%%xmm7\n\t"
+    OC_DERING_ROW_SSE2(0x11,0x21,0x12,0x00,0x10,0x00,0x10,0x00)
+    OC_DERING_ROW_SSE2(0x21,0x31,0x22,0x10,0x20,0x20,0x30,0x20)
+    OC_DERING_ROW_SSE2(0x31,0x41,0x32,0x20,0x30,0x40,0x50,0x40)
+    OC_DERING_ROW_SSE2(0x41,0x51,0x42,0x30,0x40,0x60,0x70,0x60)
+    OC_DERING_ROW_SSE2(0x51,0x61,0x52,0x40,0x50,0x80,0x90,0x80)
+    OC_DERING_ROW_SSE2(0x61,0x71,0x62,0x50,0x60,0xA0,0xB0,0xA0)
+    OC_DERING_ROW_SSE2(0x71,0x81,0x72,0x60,0x70,0xC0,0xD0,0xC0)
+    OC_DERING_ROW_SSE2(0x81,0x91,0x82,0x70,0x80,0xE0,0xF0,0xE0)
+    :[p]"=m"(OC_ARRAY_OPERAND(ogg_int32_t,p,64))
+    :[pix]"m"(OC_CONST_ARRAY_OPERAND(unsigned char,pix,160)),
+     [vmod]"m"(OC_CONST_ARRAY_OPERAND(ogg_int16_t,vmod,72)),
+     [hmod]"m"(OC_CONST_ARRAY_OPERAND(ogg_int16_t,hmod,128)),
+     [c]"r"(OC_DERING_CONSTS_SSE2)
+  );
+  /*Now add in the contributions of the filtered neighbors above and to the
+     left.*/
+  dst=_idata;
+  for(by=0;by<8;by++){
+    int left;
+    left=dst[-!(_b&1)];
+    for(bx=0;bx<8;bx++){
+      left=OC_CLAMP255(p[(by<<3)+bx]+hmod[(by<<4)+bx]*left
+       +vmod[(by<<3)+bx]*psrc[bx]>>7);
+      dst[bx]=(unsigned char)left;
+    }
+    psrc=dst;
+    dst+=_ystride;
+  }
+}
+
+#endif
@@ -0,0 +1,31 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+#include "x86dec.h"
+
+#if defined(OC_X86_ASM)
+
+void oc_dec_accel_init_x86(oc_dec_ctx *_dec){
+  oc_dec_accel_init_c(_dec);
+# if defined(OC_DEC_USE_VTABLE)
+  if(_dec->state.cpu_flags&OC_CPU_X86_SSE2){
+    _dec->opt_vtable.filter_hedge=oc_filter_hedge_sse2;
+    _dec->opt_vtable.filter_vedge=oc_filter_vedge_sse2;
+    _dec->opt_vtable.dering_block=oc_dering_block_sse2;
+  }
+# endif
+}
+#endif
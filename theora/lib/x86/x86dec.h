@@ -0,0 +1,55 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function:
+    last mod: $Id$
+
+ ********************************************************************/
+
+#if !defined(_x86_x86dec_H)
+# define _x86_x86dec_H (1)
+# include "x86int.h"
+
+# if defined(OC_X86_ASM)
+#  define oc_dec_accel_init oc_dec_accel_init_x86
+#  if defined(OC_X86_64_ASM)
+/*x86-64 guarantees SIMD support up through at least SSE2.
+  If the best routine we have available only needs SSE2 (which at the moment
+   covers all of them), then we can avoid runtime detection and the indirect
+   call.*/
+#   define oc_filter_hedge(_dec,_dst,_dst_ystride,_src,_src_ystride,_qstep, \
+ _flimit,_variance0,_variance1) \
+  oc_filter_hedge_sse2(_dst,_dst_ystride,_src,_src_ystride, \
+   _qstep,_flimit,_variance0,_variance1)
+#   define oc_filter_vedge(_dec,_dst,_dst_ystride,_qstep,_flimit,_variances) \
+  oc_filter_vedge_sse2(_dst,_dst_ystride,_qstep,_flimit,_variances)
+#   define oc_dering_block(_dec,_idata,_ystride,_b,_dc_scale,_sharp_mod, \
+ _strong) \
+  oc_dering_block_sse2(_idata,_ystride,_b,_dc_scale,_sharp_mod,_strong)
+#  else
+#   define OC_DEC_USE_VTABLE (1)
+#  endif
+# endif
+
+# include "../decint.h"
+
+void oc_dec_accel_init_x86(oc_dec_ctx *_dec);
+
+void oc_filter_hedge_sse2(unsigned char *_dst,int _dst_ystride,
+ const unsigned char *_src,int _src_ystride,int _qstep,int _flimit,
+ int *_variance0,int *_variance1);
+void oc_filter_vedge_sse2(unsigned char *_dst,int _dst_ystride,
+ int _qstep,int _flimit,int *_variances);
+void oc_dering_block_sse2(unsigned char *_idata,int _ystride,int _b,
+ int _dc_scale,int _sharp_mod,int _strong);
+
+#endif
@@ -0,0 +1,344 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function: measures decoding speed at 720p, 1080p and 2160p with 1 to N
+   threads and the latency of restarting the decoder for a seek or a loop,
+   and checks that every thread count and restart gives the same output
+  last mod: $Id$
+
+ ********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+# include <windows.h>
+#else
+# include <sys/time.h>
+#endif
+#include "theora/theoradec.h"
+#include "theora/theoraenc.h"
+
+/*The number of frames encoded per picture size when none is given.*/
+#define OC_BENCH_NFRAMES  (30)
+/*The highest thread count measured when none is given.*/
+#define OC_BENCH_NTHREADS (4)
+/*The number of times each way of restarting the decoder is measured when
+   none is given.*/
+#define OC_BENCH_NRESTARTS (10)
+
+typedef struct oc_bench_stream oc_bench_stream;
+
+/*An encoded test sequence, kept in memory so only decoding is timed.*/
+struct oc_bench_stream{
+  th_info        info;
+  th_setup_info *setup;
+  ogg_packet    *packets;
+  int            npackets;
+};
+
+static const int OC_BENCH_SIZES[3][2]={
+  {1280,720},
+  {1920,1080},
+  {3840,2160}
+};
+
+static double oc_bench_time(void){
+#if defined(_WIN32)
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart/(double)frequency.QuadPart;
+#else
+  struct timeval tv;
+  gettimeofday(&tv,NULL);
+  return tv.tv_sec+tv.tv_usec*1E-6;
+#endif
+}
+
+static void oc_bench_copy_packet(ogg_packet *_dst,const ogg_packet *_src){
+  *_dst=*_src;
+  _dst->packet=(unsigned char *)malloc(_src->bytes>0?_src->bytes:1);
+  memcpy(_dst->packet,_src->packet,_src->bytes);
+}
+
+/*Fills the picture with a gradient, a moving grid of blocks and some noise,
+   so key frames and inter frames with motion both cost something to decode.*/
+static void oc_bench_fill(th_ycbcr_buffer _ycbcr,int _frame,unsigned *_seed){
+  int pli;
+  for(pli=0;pli<3;pli++){
+    unsigned char *data;
+    int            x;
+    int            y;
+    data=_ycbcr[pli].data;
+    for(y=0;y<_ycbcr[pli].height;y++){
+      for(x=0;x<_ycbcr[pli].width;x++){
+        int v;
+        *_seed=*_seed*1103515245U+12345U;
+        v=(x+y)*255/(_ycbcr[pli].width+_ycbcr[pli].height);
+        if((((x+_frame*4)>>5)+((y+_frame*2)>>5))&1)v=255-v;
+        v+=(int)(*_seed>>24&15)-8;
+        data[y*_ycbcr[pli].stride+x]=(unsigned char)(v<0?0:v>255?255:v);
+      }
+    }
+  }
+}
+
+static int oc_bench_encode(oc_bench_stream *_stream,int _width,int _height,
+ int _nframes){
+  th_info          info;
+  th_enc_ctx      *enc;
+  th_comment       tc;
+  th_ycbcr_buffer  ycbcr;
+  ogg_packet       op;
+  unsigned char   *planes;
+  unsigned         seed;
+  int              splevel;
+  int              npackets;
+  int              pli;
+  int              i;
+  th_info_init(&info);
+  info.frame_width=(_width+15)&~15;
+  info.frame_height=(_height+15)&~15;
+  info.pic_width=_width;
+  info.pic_height=_height;
+  info.pic_x=0;
+  info.pic_y=0;
+  info.fps_numerator=30;
+  info.fps_denominator=1;
+  info.pixel_fmt=TH_PF_420;
+  info.quality=48;
+  enc=th_encode_alloc(&info);
+  th_info_clear(&info);
+  if(enc==NULL)return 1;
+  /*Only the decoder is measured, so the encoder may as well be quick.*/
+  splevel=0;
+  th_encode_ctl(enc,TH_ENCCTL_GET_SPLEVEL_MAX,&splevel,sizeof(splevel));
+  th_encode_ctl(enc,TH_ENCCTL_SET_SPLEVEL,&splevel,sizeof(splevel));
+  _stream->packets=(ogg_packet *)malloc((_nframes+3)*sizeof(*_stream->packets));
+  npackets=0;
+  th_comment_init(&tc);
+  th_info_init(&_stream->info);
+  _stream->setup=NULL;
+  while(th_encode_flushheader(enc,&tc,&op)>0){
+    th_decode_headerin(&_stream->info,&tc,&_stream->setup,&op);
+  }
+  th_comment_clear(&tc);
+  for(pli=0;pli<3;pli++){
+    ycbcr[pli].width=pli?_stream->info.frame_width>>1:
+     _stream->info.frame_width;
+    ycbcr[pli].height=pli?_stream->info.frame_height>>1:
+     _stream->info.frame_height;
+    ycbcr[pli].stride=ycbcr[pli].width;
+  }
+  planes=(unsigned char *)malloc(ycbcr[0].width*ycbcr[0].height*3/2);
+  ycbcr[0].data=planes;
+  ycbcr[1].data=ycbcr[0].data+ycbcr[0].width*ycbcr[0].height;
+  ycbcr[2].data=ycbcr[1].data+ycbcr[1].width*ycbcr[1].height;
+  seed=1;
+  for(i=0;i<_nframes;i++){
+    oc_bench_fill(ycbcr,i,&seed);
+    th_encode_ycbcr_in(enc,ycbcr);
+    while(th_encode_packetout(enc,i==_nframes-1,&op)>0){
+      oc_bench_copy_packet(_stream->packets+npackets++,&op);
+    }
+  }
+  free(planes);
+  th_encode_free(enc);
+  _stream->npackets=npackets;
+  return _stream->setup==NULL;
+}
+
+static void oc_bench_clear(oc_bench_stream *_stream){
+  int i;
+  for(i=0;i<_stream->npackets;i++)free(_stream->packets[i].packet);
+  free(_stream->packets);
+  th_setup_free(_stream->setup);
+  th_info_clear(&_stream->info);
+}
+
+static unsigned oc_bench_hash(th_dec_ctx *_dec,unsigned _hash){
+  th_ycbcr_buffer ycbcr;
+  int             pli;
+  th_decode_ycbcr_out(_dec,ycbcr);
+  for(pli=0;pli<3;pli++){
+    int x;
+    int y;
+    for(y=0;y<ycbcr[pli].height;y++){
+      const unsigned char *row;
+      row=ycbcr[pli].data+y*ycbcr[pli].stride;
+      for(x=0;x<ycbcr[pli].width;x++)_hash=(_hash^row[x])*16777619U;
+    }
+  }
+  return _hash;
+}
+
+/*Decodes the whole sequence.
+  Return: The time it took in seconds, or a negative value if the decoder
+   doesn't support _nthreads threads.*/
+static double oc_bench_decode(oc_bench_stream *_stream,int _nthreads,
+ unsigned *_hash){
+  th_dec_ctx  *dec;
+  ogg_int64_t  granpos;
+  double       start;
+  double       elapsed;
+  int          i;
+  dec=th_decode_alloc(&_stream->info,_stream->setup);
+  if(dec==NULL)return -1;
+  if(th_decode_ctl(dec,TH_DECCTL_SET_THREAD_COUNT,
+   &_nthreads,sizeof(_nthreads))<0){
+    th_decode_free(dec);
+    return -1;
+  }
+  *_hash=2166136261U;
+  elapsed=0;
+  for(i=0;i<_stream->npackets;i++){
+    start=oc_bench_time();
+    if(th_decode_packetin(dec,_stream->packets+i,&granpos)<0)break;
+    elapsed+=oc_bench_time()-start;
+    /*Hashing isn't timed, it only proves the threads didn't change the
+       output.*/
+    *_hash=oc_bench_hash(dec,*_hash);
+  }
+  th_decode_free(dec);
+  return elapsed;
+}
+
+/*Restarts decoding at the first frame the way a player does for a seek or
+   a loop, either by allocating a new decoder or by resetting the old one.*/
+static th_dec_ctx *oc_bench_restart(oc_bench_stream *_stream,
+ th_dec_ctx *_dec,int _reset,int _nthreads){
+  if(_dec!=NULL&&_reset){
+    th_decode_ctl(_dec,TH_DECCTL_RESET,NULL,0);
+    return _dec;
+  }
+  if(_dec!=NULL)th_decode_free(_dec);
+  _dec=th_decode_alloc(&_stream->info,_stream->setup);
+  /*A new decoder has to start its thread team again.*/
+  th_decode_ctl(_dec,TH_DECCTL_SET_THREAD_COUNT,&_nthreads,sizeof(_nthreads));
+  return _dec;
+}
+
+/*Measures the time to restart the decoder, the time until the first frame
+   is decoded after a restart (a loop transition), and the time until the
+   middle frame is decoded after a restart (a seek).*/
+static int oc_bench_restarts(oc_bench_stream *_stream,int _nthreads,
+ int _nrestarts){
+  static const char *OC_BENCH_RESTART_NAMES[2]={"free+alloc","reset"};
+  double   restart[2];
+  double   first[2];
+  double   seek[2];
+  unsigned hash[2];
+  int      target;
+  int      reset;
+  int      ret;
+  ret=0;
+  target=_stream->npackets/2;
+  for(reset=0;reset<2;reset++){
+    th_dec_ctx  *dec;
+    ogg_int64_t  granpos;
+    int          i;
+    int          j;
+    dec=oc_bench_restart(_stream,NULL,0,_nthreads);
+    restart[reset]=first[reset]=seek[reset]=0;
+    for(i=0;i<_nrestarts;i++){
+      double start;
+      double t;
+      start=oc_bench_time();
+      dec=oc_bench_restart(_stream,dec,reset,_nthreads);
+      t=oc_bench_time();
+      restart[reset]+=t-start;
+      th_decode_packetin(dec,_stream->packets,&granpos);
+      first[reset]+=oc_bench_time()-start;
+      if(i==0)hash[reset]=oc_bench_hash(dec,2166136261U);
+      start=oc_bench_time();
+      dec=oc_bench_restart(_stream,dec,reset,_nthreads);
+      for(j=0;j<=target;j++)th_decode_packetin(dec,_stream->packets+j,&granpos);
+      seek[reset]+=oc_bench_time()-start;
+    }
+    th_decode_free(dec);
+  }
+  if(hash[1]!=hash[0]){
+    fprintf(stderr,"%ix%i: the first frame after a reset differs from the "
+     "first frame of a new decoder.\n",_stream->info.pic_width,
+     _stream->info.pic_height);
+    ret=1;
+  }
+  for(reset=0;reset<2;reset++){
+    printf("%4ix%-4i %-10s: restart %7.3f ms, first frame %7.2f ms, "
+     "seek to frame %i %7.2f ms\n",_stream->info.pic_width,
+     _stream->info.pic_height,OC_BENCH_RESTART_NAMES[reset],
+     restart[reset]*1000/_nrestarts,first[reset]*1000/_nrestarts,target,
+     seek[reset]*1000/_nrestarts);
+  }
+  return ret;
+}
+
+int main(int _argc,char **_argv){
+  oc_bench_stream stream;
+  int             nframes;
+  int             nthreads;
+  int             nrestarts;
+  int             sizei;
+  int             ret;
+  nframes=_argc>1?atoi(_argv[1]):OC_BENCH_NFRAMES;
+  nthreads=_argc>2?atoi(_argv[2]):OC_BENCH_NTHREADS;
+  nrestarts=_argc>3?atoi(_argv[3]):OC_BENCH_NRESTARTS;
+  if(nframes<1||nthreads<1||nrestarts<1){
+    fprintf(stderr,"Usage: %s [<frames> [<max threads> [<restarts>]]]\n",
+     _argv[0]);
+    return 1;
+  }
+  ret=0;
+  for(sizei=0;sizei<3;sizei++){
+    double   base;
+    unsigned base_hash;
+    int      maxthreads;
+    int      t;
+    if(oc_bench_encode(&stream,OC_BENCH_SIZES[sizei][0],
+     OC_BENCH_SIZES[sizei][1],nframes)){
+      fprintf(stderr,"Encoding the %ix%i test sequence failed.\n",
+       OC_BENCH_SIZES[sizei][0],OC_BENCH_SIZES[sizei][1]);
+      return 1;
+    }
+    base=0;
+    base_hash=0;
+    maxthreads=1;
+    for(t=1;t<=nthreads;t++){
+      unsigned hash;
+      double   elapsed;
+      elapsed=oc_bench_decode(&stream,t,&hash);
+      if(elapsed<0){
+        printf("%ix%i: %i threads not supported.\n",
+         OC_BENCH_SIZES[sizei][0],OC_BENCH_SIZES[sizei][1],t);
+        break;
+      }
+      if(t==1){
+        base=elapsed;
+        base_hash=hash;
+      }
+      else if(hash!=base_hash){
+        fprintf(stderr,"%ix%i: output with %i threads differs from 1 "
+         "thread.\n",OC_BENCH_SIZES[sizei][0],OC_BENCH_SIZES[sizei][1],t);
+        ret=1;
+      }
+      maxthreads=t;
+      printf("%4ix%-4i threads %i: %7.2f ms/frame, %6.1f fps, x%.2f\n",
+       OC_BENCH_SIZES[sizei][0],OC_BENCH_SIZES[sizei][1],t,
+       elapsed*1000/stream.npackets,stream.npackets/elapsed,base/elapsed);
+    }
+    ret|=oc_bench_restarts(&stream,maxthreads,nrestarts);
+    oc_bench_clear(&stream);
+  }
+  return ret;
+}
@@ -0,0 +1,175 @@
+/********************************************************************
+ *                                                                  *
+ * THIS FILE IS PART OF THE OggTheora SOFTWARE CODEC SOURCE CODE.   *
+ * USE, DISTRIBUTION AND REPRODUCTION OF THIS LIBRARY SOURCE IS     *
+ * GOVERNED BY A BSD-STYLE SOURCE LICENSE INCLUDED WITH THIS SOURCE *
+ * IN 'COPYING'. PLEASE READ THESE TERMS BEFORE DISTRIBUTING.       *
+ *                                                                  *
+ * THE Theora SOURCE CODE IS COPYRIGHT (C) 2002-2009                *
+ * by the Xiph.Org Foundation and contributors http://www.xiph.org/ *
+ *                                                                  *
+ ********************************************************************
+
+  function: checks the accelerated post-processing filters against the C
+   reference implementations
+  last mod: $Id$
+
+ ********************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(OC_X86_ASM)
+# include "../lib/x86/x86cpu.h"
+# include "../lib/x86/x86dec.h"
+#endif
+
+/*The size of the test picture.
+  The block under test sits in its middle, with enough border on every side
+   for whatever the filters read around it.*/
+#define OC_TEST_STRIDE (32)
+#define OC_TEST_OFFSET (8*OC_TEST_STRIDE+8)
+#define OC_NTESTS      (100000)
+
+static unsigned oc_test_seed=1;
+
+static int oc_test_rand(int _n){
+  oc_test_seed=oc_test_seed*1103515245U+12345U;
+  return (int)((oc_test_seed>>8)%(unsigned)_n);
+}
+
+/*Fills the test picture with a gradient plus noise.
+  Mostly low noise, so the filters' smooth-region paths are taken, but
+   sometimes strong noise or a hard edge, so the others are, too.*/
+static void oc_test_fill(unsigned char _buf[OC_TEST_STRIDE*OC_TEST_STRIDE]){
+  int base;
+  int dx;
+  int dy;
+  int noise;
+  int edge;
+  int x;
+  int y;
+  base=oc_test_rand(256);
+  dx=oc_test_rand(9)-4;
+  dy=oc_test_rand(9)-4;
+  noise=1+(oc_test_rand(4)==0?oc_test_rand(128):oc_test_rand(8));
+  edge=oc_test_rand(3)==0?oc_test_rand(OC_TEST_STRIDE):OC_TEST_STRIDE;
+  for(y=0;y<OC_TEST_STRIDE;y++)for(x=0;x<OC_TEST_STRIDE;x++){
+    int v;
+    v=base+dx*x+dy*y+oc_test_rand(noise)-(noise>>1);
+    if(y>=edge)v+=96;
+    _buf[y*OC_TEST_STRIDE+x]=(unsigned char)(v<0?0:v>255?255:v);
+  }
+}
+
+#if defined(OC_X86_ASM)
+static int oc_test_filter_hedge(void){
+  unsigned char src[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  unsigned char dst0[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  unsigned char dst1[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  int           i;
+  for(i=0;i<OC_NTESTS;i++){
+    int var0[4];
+    int var1[4];
+    int qstep;
+    int flimit;
+    oc_test_fill(src);
+    oc_test_fill(dst0);
+    memcpy(dst1,dst0,sizeof(dst1));
+    var0[0]=var1[0]=oc_test_rand(1024);
+    var0[1]=var1[1]=oc_test_rand(1024);
+    var0[2]=var1[2]=oc_test_rand(1024);
+    var0[3]=var1[3]=oc_test_rand(1024);
+    qstep=1+oc_test_rand(128);
+    flimit=qstep*3>>2;
+    oc_filter_hedge_c(dst0+OC_TEST_OFFSET,OC_TEST_STRIDE,
+     src+OC_TEST_OFFSET-OC_TEST_STRIDE,OC_TEST_STRIDE,qstep,flimit,
+     var0,var0+2);
+    oc_filter_hedge_sse2(dst1+OC_TEST_OFFSET,OC_TEST_STRIDE,
+     src+OC_TEST_OFFSET-OC_TEST_STRIDE,OC_TEST_STRIDE,qstep,flimit,
+     var1,var1+2);
+    if(memcmp(dst0,dst1,sizeof(dst0))!=0||memcmp(var0,var1,sizeof(var0))!=0){
+      fprintf(stderr,"oc_filter_hedge_sse2 mismatch in test %i "
+       "(qstep %i).\n",i,qstep);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int oc_test_filter_vedge(void){
+  unsigned char dst0[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  unsigned char dst1[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  int           i;
+  for(i=0;i<OC_NTESTS;i++){
+    int var0[3];
+    int var1[3];
+    int qstep;
+    int flimit;
+    oc_test_fill(dst0);
+    memcpy(dst1,dst0,sizeof(dst1));
+    var0[0]=var1[0]=oc_test_rand(1024);
+    var0[1]=var1[1]=oc_test_rand(1024);
+    var0[2]=var1[2]=oc_test_rand(1024);
+    qstep=1+oc_test_rand(128);
+    flimit=qstep*3>>2;
+    oc_filter_vedge_c(dst0+OC_TEST_OFFSET,OC_TEST_STRIDE,qstep,flimit,var0);
+    oc_filter_vedge_sse2(dst1+OC_TEST_OFFSET,OC_TEST_STRIDE,qstep,flimit,var1);
+    if(memcmp(dst0,dst1,sizeof(dst0))!=0||memcmp(var0,var1,sizeof(var0))!=0){
+      fprintf(stderr,"oc_filter_vedge_sse2 mismatch in test %i "
+       "(qstep %i).\n",i,qstep);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static int oc_test_dering_block(void){
+  unsigned char dst0[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  unsigned char dst1[OC_TEST_STRIDE*OC_TEST_STRIDE];
+  int           i;
+  for(i=0;i<OC_NTESTS;i++){
+    int b;
+    int dc_scale;
+    int sharp_mod;
+    int strong;
+    oc_test_fill(dst0);
+    memcpy(dst1,dst0,sizeof(dst1));
+    /*Every combination of plane edges.*/
+    b=i&15;
+    dc_scale=1+oc_test_rand(200);
+    sharp_mod=-oc_test_rand(64);
+    strong=oc_test_rand(2);
+    oc_dering_block_c(dst0+OC_TEST_OFFSET,OC_TEST_STRIDE,
+     b,dc_scale,sharp_mod,strong);
+    oc_dering_block_sse2(dst1+OC_TEST_OFFSET,OC_TEST_STRIDE,
+     b,dc_scale,sharp_mod,strong);
+    if(memcmp(dst0,dst1,sizeof(dst0))!=0){
+      fprintf(stderr,"oc_dering_block_sse2 mismatch in test %i "
+       "(b %i, dc_scale %i, sharp_mod %i, strong %i).\n",
+       i,b,dc_scale,sharp_mod,strong);
+      return 1;
+    }
+  }
+  return 0;
+}
+#endif
+
+int main(int _argc,char **_argv){
+  int ret;
+  ret=0;
+#if defined(OC_X86_ASM)
+  if(!(oc_cpu_flags_get()&OC_CPU_X86_SSE2)){
+    fprintf(stderr,"SSE2 is not available, skipping.\n");
+    return 0;
+  }
+  ret|=oc_test_filter_hedge();
+  ret|=oc_test_filter_vedge();
+  ret|=oc_test_dering_block();
+#else
+  fprintf(stderr,"No accelerated post-processing filters, skipping.\n");
+#endif
+  if(!ret)fprintf(stderr,"All post-processing filters are bit-exact.\n");
+  return ret;
+}
@@ -42,6 +42,14 @@ namespace theoraplayer
 		virtual void seek(int64_t byteIndex) = 0;
 		/// @return A string representation of the DataSource, eg 'File: source.ogg'
 		virtual std::string toString() const = 0;
+		/// @return A new data source that reads the same data with a position of its own, NULL if the data can't be read twice. The
+		/// returned object has to be deleted before this one.
+		/// @note Used by clips that read from two positions of the stream at the same time, e.g. to pre-roll the next iteration.
+		virtual DataSource* clone();
+		/// @return A name that only data sources reading the same data return, e.g. the full path of a file, or an empty string if the
+		/// data can't be identified. This is the default.
+		/// @note Clips of data sources with the same asset ID share the headers parsed from the stream.
+		virtual std::string getAssetId() const;
 
 	};
 
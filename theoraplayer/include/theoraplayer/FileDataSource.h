@@ -32,6 +32,9 @@ namespace theoraplayer
 
 		int read(void* output, int nBytes);
 		void seek(int64_t byte_index);
+		/// @return A data source that opens the file a second time.
+		DataSource* clone();
+		inline std::string getAssetId() const { return this->fullFilename; }
 
 		inline std::string toString() const { return this->filename + " (format: " + this->formatName + ")"; }
 
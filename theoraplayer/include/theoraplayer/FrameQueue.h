@@ -41,6 +41,9 @@ namespace theoraplayer
 		/// @brief This is a non-mutexed thread-unsafe version.
 		/// @see getFirstAvailableFrame
 		VideoFrame* _getFirstAvailableFrame() const;
+		/// @brief Returns the frame at the given position in the queue or NULL if it's not available. Used by clip views that read behind the front.
+		/// @note This is a non-mutexed thread-unsafe function.
+		VideoFrame* _getAvailableFrame(int index) const;
 
 		/// @return The number of ready frames.
 		int getReadyCount();
@@ -75,14 +78,34 @@ namespace theoraplayer
 		/// @brief Frees all decoded frames for reuse.
 		/// @note This does not free the memory, it just marks the frames as "freed".
 		void clear();
+		/// @brief This is a non-mutexed thread-unsafe version.
+		/// @see clear
+		void _clear();
+
+		/// @brief Leases a frame of this queue. A leased frame keeps its picture when it's popped, cleared or the queue is resized, it
+		/// leaves the queue instead and a spare frame takes its place, so the decoder keeps going while the consumer holds on to it.
+		/// @note Every lease has to be given back with release() before the clip is destroyed. Frames can be leased several times.
+		void acquire(VideoFrame* frame);
+		/// @brief Gives back a lease. Once the last lease is given back, a frame that left the queue becomes a spare frame.
+		void release(VideoFrame* frame);
 
 	protected:
 		std::list<VideoFrame*> queue;
+		/// @brief Leased frames that left the queue.
+		std::list<VideoFrame*> leasedFrames;
+		/// @brief Leased frames that left the queue before it was resized, they are deleted once they are released.
+		std::list<VideoFrame*> retiredFrames;
+		/// @brief Frames that can take the place of a leased frame.
+		std::list<VideoFrame*> spareFrames;
+		/// @brief Requested number of frames in the queue.
+		int size;
 		VideoClip* parent;
 		Mutex* mutex;
 
 		/// @brief The implementation that returns a VideoFrame instance.
 		VideoFrame* _createFrameInstance(VideoClip* clip);
+		/// @return A cleared spare frame, a new one if there are no spare frames. NULL if out of memory.
+		VideoFrame* _getSpareFrame();
 
 	};
 
@@ -24,6 +24,8 @@ namespace theoraplayer
 {
 	class AudioInterfaceFactory;
 	class DataSource;
+	class FrameCacheWriter;
+	class LoaderThread;
 	class Mutex;
 	class WorkerThread;
 
@@ -31,6 +33,7 @@ namespace theoraplayer
 	class theoraplayerExport Manager
 	{
 	public:
+		friend class LoaderThread;
 		friend class WorkerThread;
 
 		Manager();
@@ -55,18 +58,44 @@ namespace theoraplayer
 
 		VideoClip* createVideoClip(const std::string& filename, OutputMode outputMode = FORMAT_RGB, int precachedFramesCountOverride = 0, bool usePotStride = false);
 		VideoClip* createVideoClip(DataSource* dataSource, OutputMode outputMode = FORMAT_RGB, int precachedFramesCountOverride = 0, bool usePotStride = false);
+		/// @brief Creates a video clip that is played from a file of already converted frames when possible.
+		/// If cacheFilename holds a complete frame cache of this video file, output mode and stride, frames are read from the memory-mapped cache without decoding.
+		/// Otherwise the video is decoded as usual and its converted frames are written to cacheFilename during the first iteration.
+		/// @note Frame caches are large (every frame is stored uncompressed) and hold no audio, so this is meant for short clips without sound.
+		VideoClip* createCachedVideoClip(const std::string& filename, const std::string& cacheFilename, OutputMode outputMode = FORMAT_RGB, int precachedFramesCountOverride = 0, bool usePotStride = false);
+		/// @brief Creates a video clip without blocking the calling thread.
+		/// The clip is loaded (headers, duration and first frame) on a separate thread and can't be played before VideoClip::isLoaded() returns true.
+		/// @param[in] callback Called from update() once loading is done, with success set to false if the clip couldn't be loaded. Failed clips still have to be destroyed with destroyVideoClip().
+		/// @return The clip or NULL if the format of the data source isn't supported.
+		VideoClip* createVideoClipAsync(const std::string& filename, OutputMode outputMode = FORMAT_RGB, int precachedFramesCountOverride = 0, bool usePotStride = false, void (*callback)(VideoClip* clip, bool success) = NULL);
+		VideoClip* createVideoClipAsync(DataSource* dataSource, OutputMode outputMode = FORMAT_RGB, int precachedFramesCountOverride = 0, bool usePotStride = false, void (*callback)(VideoClip* clip, bool success) = NULL);
+		/// @brief Removes the clip from playback and deletes it.
+		/// @note Doesn't wait for a thread that is still loading or decoding the clip, that thread deletes the clip once it's done. The load callback isn't called for destroyed clips.
 		void destroyVideoClip(VideoClip* clip);
 
 		void update(float timeDelta);
+		/// @return The clips that had a frame due at their time positions of the last update(), except clips with a frame callback,
+		/// which got their frames already. Only these clips have to be read with VideoClip::fetchNextFrame().
+		/// @see VideoClip::setFrameCallback()
+		inline const std::vector<VideoClip*>& getClipsWithDueFrames() const { return this->dueClips; }
 
 	protected:
 		typedef std::vector<VideoClip*> ClipList;
 		typedef std::vector<WorkerThread*> ThreadList;
+		typedef std::vector<LoaderThread*> LoaderThreadList;
 
 		/// @brief Stores pointers to worker threads which are decoding video and audio
 		ThreadList workerThreads;
+		/// @brief Stores pointers to threads loading clips created with createVideoClipAsync()
+		LoaderThreadList loaderThreads;
 		/// @brief Stores pointers to created video clips
 		ClipList clips;
+		/// @brief Stores pointers to destroyed clips that are deleted once the thread using them is done
+		ClipList retiringClips;
+		/// @brief Clips that update() still has to call a callback for, destroying them leaves deleting them to update()
+		ClipList callbackClips;
+		/// @brief Clips without a frame callback that had a frame due in the last update
+		ClipList dueClips;
 		/// @brief Stores pointer to clips that were docoded in the past in order to achieve fair scheduling
 		std::list<VideoClip*> workLog;
 		int defaultPrecachedFramesCount;
@@ -76,8 +105,24 @@ namespace theoraplayer
 		void _createWorkerThreads(int count);
 		void _destroyWorkerThreads();
 		void _destroyWorkerThreads(int count);
+		VideoClip* _createVideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride, FrameCacheWriter* frameCacheWriter);
+		/// @brief Creates a clip instance of the data source's format without loading it.
+		VideoClip* _instantiateVideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride);
+		/// @brief Reads the headers of a clip and decodes its first frame. The clip must not be registered with the worker threads yet.
+		void _loadVideoClip(VideoClip* clip, DataSource* dataSource, FrameCacheWriter* frameCacheWriter);
 		/// @brief Called by WorkerThread to request a VideoClip instance to work on decoding
 		VideoClip* _requestWork(WorkerThread* caller);
+		/// @brief Called by WorkerThread when it's done with its assigned clip.
+		/// @param[in] decoded Whether a frame was decoded, so update() checks the clip's frame queue again.
+		/// @return True if the clip was destroyed in the meantime and has to be deleted by the caller.
+		bool _finishWork(WorkerThread* caller, bool decoded);
+		void _removeRetiringClip(VideoClip* clip);
+		/// @return Whether update() still has to call a callback for the clip. workMutex has to be locked.
+		bool _isCallbackPending(VideoClip* clip);
+		/// @brief Used by WorkerThread to poll for work more often while clips are being scrubbed.
+		bool _hasScrubbingClips();
+		/// @brief Adjusts the post-processing level of a clip in automatic post-processing mode depending on whether decoding keeps up.
+		void _updatePostProcessing(VideoClip* clip, float timeDelta);
 
 	};
 
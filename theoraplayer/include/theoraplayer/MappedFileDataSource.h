@@ -0,0 +1,64 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Provides an interface for a video data source from a memory-mapped file.
+
+#ifndef THEORAPLAYER_MAPPED_FILE_DATA_SOURCE_H
+#define THEORAPLAYER_MAPPED_FILE_DATA_SOURCE_H
+
+#include "DataSource.h"
+#include "theoraplayerExport.h"
+
+namespace theoraplayer
+{
+	/// @brief Maps the entire file into memory and streams from the mapping. Reads are plain memory copies and the
+	/// operating system pages the data in on demand, so unlike MemoryDataSource the file isn't loaded up front.
+	/// @note On platforms without file mapping support (WinRT) the file is preloaded like in MemoryDataSource.
+	class theoraplayerExport MappedFileDataSource : public DataSource
+	{
+	public:
+		MappedFileDataSource(const std::string& filename);
+		MappedFileDataSource(const std::string& filename, const std::string& formatName);
+		~MappedFileDataSource();
+
+		inline std::string getFormatName() const { return this->formatName; }
+		inline std::string getFilename() const { return this->filename; }
+		int64_t getSize();
+		inline int64_t getPosition() { return this->position; }
+		/// @return Pointer to the mapped file contents.
+		const unsigned char* getData();
+
+		int read(void* output, int count);
+		void seek(int64_t byteIndex);
+		/// @return A data source that reads the same mapping without mapping the file again.
+		DataSource* clone();
+		inline std::string getAssetId() const { return this->fullFilename; }
+
+		inline std::string toString() const { return "MAP:" + this->filename + " (format: " + this->formatName + ")"; }
+
+	private:
+		std::string filename;
+		std::string fullFilename;
+		std::string formatName;
+		int64_t size;
+		int64_t position;
+		unsigned char* data;
+		bool mapped;
+#if defined(_WIN32) && !defined(_WINRT)
+		void* fileHandle;
+		void* mappingHandle;
+#endif
+
+		void _mapFile();
+
+	};
+
+}
+#endif
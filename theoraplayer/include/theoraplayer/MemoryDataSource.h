@@ -34,6 +34,10 @@ namespace theoraplayer
 
 		int read(void* output, int count);
 		void seek(int64_t byteIndex);
+		/// @return A data source that reads the same memory without copying it.
+		DataSource* clone();
+		/// @return The full path of the file if the data was loaded from one, an empty string for data passed to the constructor.
+		inline std::string getAssetId() const { return this->fullFilename; }
 
 		inline std::string toString() const { return "MEM:" + this->filename + " (format: " + this->formatName + ")"; }
 
@@ -15,6 +15,11 @@
 
 // no theoraplayer namespace, because this is included in C files
 
+// chroma subsampling of the u and v planes
+#define THEORAPLAYER_CHROMA_420 0
+#define THEORAPLAYER_CHROMA_422 1
+#define THEORAPLAYER_CHROMA_444 2
+
 struct Theoraplayer_PixelTransform
 {
 	unsigned char* raw;
@@ -28,6 +33,14 @@ struct Theoraplayer_PixelTransform
 	unsigned int yStride;
 	unsigned int uStride;
 	unsigned int vStride;
+	/// @brief Whether the 16 bit output modes use ordered dithering.
+	int dither;
+	/// @brief Chroma subsampling of the u and v planes, one of the THEORAPLAYER_CHROMA_* values. 0 is 4:2:0.
+	int chroma;
+	/// @brief Whether colors are multiplied by alpha in the output modes with an alpha channel.
+	int premultiply;
+	/// @brief Distance from a luma sample to its alpha sample in the alpha half of the picture. 0 if the alpha half starts right after w.
+	unsigned int alphaOffset;
 
 };
 #endif
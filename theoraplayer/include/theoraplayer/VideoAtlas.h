@@ -0,0 +1,124 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines an atlas that shows many clips on one surface.
+
+#ifndef THEORAPLAYER_VIDEO_ATLAS_H
+#define THEORAPLAYER_VIDEO_ATLAS_H
+
+#include <map>
+#include <vector>
+
+#include "theoraplayerExport.h"
+#include "VideoClip.h"
+
+namespace theoraplayer
+{
+	/// @brief Shows the frames of many small clips on one shared surface, so they can be uploaded as a single texture instead of one
+	/// texture per clip. Every clip is assigned a region of the surface. The surface is double-buffered: update() writes the frames that
+	/// are due into the surface that isn't shown and then swaps them, so the shown surface stays unchanged while it's uploaded.
+	/// @note Frames are still converted into the clips' own frames and copied into their regions when they are due. Decoders convert
+	/// frames ahead of time, while a region only holds the picture that's shown, so frames can't be converted into the regions directly.
+	class theoraplayerExport VideoAtlas
+	{
+	public:
+		/// @brief A rectangle of the surface in pixels.
+		struct Region
+		{
+			int x;
+			int y;
+			int width;
+			int height;
+
+		};
+
+		VideoAtlas(int width, int height, OutputMode outputMode);
+		~VideoAtlas();
+
+		inline int getWidth() const { return this->width; }
+		inline int getHeight() const { return this->height; }
+		inline OutputMode getOutputMode() const { return this->outputMode; }
+		/// @return Bytes from the start of one row of the surface to the next.
+		inline int getPitch() const { return this->pitch; }
+		/// @return The surface with the frames written by the last update(). It isn't changed until the next update().
+		inline unsigned char* getSurface() const { return this->surfaces[this->front]; }
+		/// @return The regions of the surface that changed in the last update(), one for every clip that got a new frame and
+		/// one for every region of a removed clip that was cleared.
+		inline const std::vector<Region>& getDirtyRegions() const { return this->dirtyRegions; }
+
+		/// @brief Assigns a region of the surface with the clip's size to the clip. From then on, update() fetches and pops the clip's
+		/// frames, the clip mustn't be read by anything else.
+		/// @return False if there's no room left for the clip.
+		/// @note The clip's output mode has to be the one of the atlas and neither may change while the clip is in the atlas. The clip
+		/// mustn't have a frame callback, see VideoClip::setFrameCallback().
+		bool addClip(VideoClip* clip);
+		/// @brief Removes the clip from the atlas. The next update() clears its region and lists it as dirty. The region is merged with
+		/// adjacent free regions and can be assigned to further clips.
+		/// @note Clips have to be removed before they are destroyed.
+		void removeClip(VideoClip* clip);
+		/// @return The region assigned to the clip, an empty region if the clip isn't in the atlas.
+		Region getRegion(VideoClip* clip) const;
+
+		/// @brief Writes the frames of all clips that are due into the surface and makes it the shown one. Call this once per tick,
+		/// after Manager::update().
+		/// @note Only the clips of Manager::getClipsWithDueFrames() and the regions that changed in the previous update() are visited, so
+		/// clips without a new frame cost nothing.
+		void update();
+
+	protected:
+		/// @brief The region of a clip.
+		struct Slot
+		{
+			Region region;
+			/// @brief Number of the update() that last wrote a picture into the region.
+			int updateIndex;
+
+		};
+
+		int width;
+		int height;
+		OutputMode outputMode;
+		/// @brief Bytes per pixel.
+		int bpp;
+		int pitch;
+		/// @brief The shown surface and the one written by the next update().
+		unsigned char* surfaces[2];
+		/// @brief Index of the shown surface.
+		int front;
+		std::map<VideoClip*, Slot> slots;
+		/// @brief Number of the current update().
+		int updateIndex;
+		/// @brief Clips whose regions hold a newer picture in the shown surface than in the other one.
+		std::vector<VideoClip*> staleClips;
+		/// @brief Regions of removed clips that can be assigned again.
+		std::vector<Region> freeRegions;
+		std::vector<Region> dirtyRegions;
+		/// @brief Regions of removed clips that still have their pictures and are cleared by the next update().
+		std::vector<Region> clearRegions;
+		/// @brief Regions cleared by the last update() that still have to be cleared in the other surface.
+		std::vector<Region> staleClearRegions;
+		/// @brief Regions are assigned left to right in rows, this is where the next one starts.
+		int rowX;
+		int rowY;
+		/// @brief Height of the highest region in the current row.
+		int rowHeight;
+
+		/// @brief Copies a picture into a region of a surface, as much of it as fits into the region.
+		void _copyPicture(const unsigned char* source, int sourcePitch, int sourceWidth, int sourceHeight, unsigned char* surface,
+			const Region& region);
+		/// @brief Fills a region of a surface with zeros.
+		void _clearRegion(unsigned char* surface, const Region& region);
+		/// @brief Adds a region to the free regions, merged with the free regions it shares a whole edge with.
+		void _addFreeRegion(Region region);
+
+	};
+
+}
+#endif
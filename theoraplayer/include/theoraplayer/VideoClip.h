@@ -13,7 +13,9 @@
 #ifndef THEORAPLAYER_VIDEO_CLIP_H
 #define THEORAPLAYER_VIDEO_CLIP_H
 
+#include <stdint.h>
 #include <string>
+#include <vector>
 
 #include "theoraplayerExport.h"
 
@@ -21,12 +23,14 @@ namespace theoraplayer
 {
 	// forward class declarations
 	class DataSource;
+	class FrameCacheWriter;
 	class FrameQueue;
 	class Manager;
 	class Mutex;
 	class WorkerThread;
 	class Timer;
 	class VideoFrame;
+	class VideoClipView;
 	class AudioInterface;
 
 	/// @brief Format of the VideoFrame pixels. Affects decoding time.
@@ -56,7 +60,32 @@ namespace theoraplayer
 		FORMAT_YUVA,
 		FORMAT_YUVX,
 		FORMAT_AYUV,
-		FORMAT_XYUV
+		FORMAT_XYUV,
+		// 16 bit formats, each pixel is a native-endian unsigned short with the channels packed from the most significant bit down,
+		// the same layout as GL_UNSIGNED_SHORT_5_6_5, GL_UNSIGNED_SHORT_4_4_4_4 and GL_UNSIGNED_SHORT_5_5_5_1
+		FORMAT_RGB565,
+		FORMAT_RGBA4444,
+		FORMAT_RGBA5551
+	};
+
+	/// @brief How much work is spent on a clip that isn't shown.
+	enum Visibility
+	{
+		/// @brief Frames are decoded and converted to the output mode.
+		VISIBILITY_VISIBLE = 0,
+		/// @brief Frames are decoded to keep the decoder and audio in sync, but they aren't converted and are never shown.
+		VISIBILITY_TIMESTAMPS_ONLY,
+		/// @brief Nothing is decoded.
+		VISIBILITY_DORMANT
+	};
+
+	/// @brief How pictures are filtered when they are downscaled, see VideoClip::setOutputScale().
+	enum ScaleFilter
+	{
+		/// @brief Averages all pixels covered by an output pixel.
+		SCALE_FILTER_BOX = 0,
+		/// @brief Interpolates between the 4 nearest pixels, faster but aliases when scaling below half size.
+		SCALE_FILTER_BILINEAR
 	};
 
 	/// @brief This object contains all data related to video playback, eg. the open source file, the frame queue etc.
@@ -71,7 +100,10 @@ namespace theoraplayer
 
 		};
 
+		friend class FrameQueue;
+		friend class LoaderThread;
 		friend class Manager;
+		friend class VideoClipView;
 		friend class VideoFrame;
 		friend class WorkerThread;
 
@@ -117,12 +149,51 @@ namespace theoraplayer
 		/// @brief Changes the audio gane in a range between 0 and 1 inclusively.
 		void setAudioGain(float gain);
 		float getPlaybackSpeed() const;
+		/// @brief Sets the playback speed. Negative values play the clip backwards.
+		/// @note Playing backwards stops at the first frame and audio is silent.
 		void setPlaybackSpeed(float speed);
+		/// @return Playback speed from which on only key frames are decoded.
+		inline float getKeyFrameSpeedThreshold() const { return this->keyFrameSpeedThreshold; }
+		/// @brief Sets the playback speed from which on only key frames are decoded, in both directions. The frames between key frames
+		/// aren't decoded at all, so fast-forwarding and rewinding cost about as much as decoding the key frames.
+		/// @note 0 disables key frame trick-play. Audio is silent while only key frames are decoded.
+		void setKeyFrameSpeedThreshold(float value);
+		/// @return Maximum number of frames held by reverse playback.
+		inline int getReverseFramesBudget() const { return this->reverseFramesBudget; }
+		/// @brief Sets how many frames reverse playback may hold. Frames are decoded forward into a buffer of this size and shown
+		/// from the back, a group of pictures that doesn't fit is decoded in several passes.
+		/// @note Decoder state checkpoints shorten the passes, see setCheckpointInterval().
+		void setReverseFramesBudget(int value);
 		/// @return Current output mode for this video object.
 		OutputMode getOutputMode() const { return this->outputMode; }
 		/// @brief Set a new output mode.
 		/// @note This discards the frame queue and ready frames will be lost.
 		void setOutputMode(OutputMode mode);
+		inline bool isDithering() const { return this->dithering; }
+		/// @brief Sets whether the 16 bit output modes apply an ordered dither, which hides the banding of the reduced color depth.
+		void setDithering(bool value);
+		inline bool isPremultipliedAlpha() const { return this->premultipliedAlpha; }
+		/// @brief Sets whether the RGB and grey output modes with an alpha channel store colors premultiplied by alpha, so renderers can
+		/// blend them without premultiplying them on their own. YUV output modes aren't affected.
+		/// @note Either way, fully transparent 16x16 pixel blocks of these modes aren't converted, they're cleared to 0.
+		void setPremultipliedAlpha(bool value);
+		/// @return Factor the decoded pictures are scaled by before they are converted to the output mode.
+		inline float getOutputScale() const { return this->outputScale; }
+		inline ScaleFilter getScaleFilter() const { return this->scaleFilter; }
+		/// @brief Downscales the decoded pictures before they are converted, eg. to show a clip as a thumbnail. Width, height, stride and
+		/// the sub-frame rectangle of the clip and its frames are scaled as well, so frame memory and conversion cost drop with the square of the factor.
+		/// @param[in] value Factor between 0 and 1, eg. 0.5 or 0.25. The width is rounded to a multiple of 4 pixels and the height to a multiple of 2.
+		/// @note Like setOutputMode() this discards the frame queue. Incremental conversion is disabled while scaling. Decoders that can't scale ignore this.
+		void setOutputScale(float value, ScaleFilter filter = SCALE_FILTER_BOX);
+		/// @return Whether only the picture rectangle is converted instead of the whole frame.
+		inline bool isOutputCropping() const { return this->outputCropping; }
+		/// @brief Sets whether frames are cropped to the picture rectangle the encoder padded to the codec block size. Frames then hold
+		/// only the picture, so they take less memory, convert faster and don't need sub-rectangle uploads. Width and height of the clip
+		/// are those of the cropped frames.
+		/// @note The 4:2:0 converters work on pairs of pixels, so a picture with an odd offset or size keeps one more column or row on
+		/// that side and getSubFrameX() etc. describe the exact picture inside the cropped frame. Clips with an alpha channel are only
+		/// cropped vertically. Like setOutputMode() this discards the frame queue. Decoders that can't crop ignore this.
+		void setOutputCropping(bool value);
 		inline bool isAutoRestart() const { return this->autoRestart; }
 		/// @brief Whether the clip should automatically and smoothly restart when the last frame was reached.
 		void setAutoRestart(bool value);
@@ -130,6 +201,12 @@ namespace theoraplayer
 		void setPriority(float priority) { this->priority = priority; }
 		/// @brief Used by Manager to schedule work.
 		float getPriorityIndex() const;
+		inline Visibility getVisibility() const { return this->visibility; }
+		/// @brief Sets how much work is spent on the clip while it isn't shown. Frames decoded without a picture advance on their own
+		/// and are skipped by fetchNextFrame(). A clip that leaves VISIBILITY_DORMANT seeks to the current time, decoding from the
+		/// key frame before it.
+		/// @note Manager gives clips that only decode timestamps less time than visible clips and doesn't decode dormant clips at all.
+		void setVisibility(Visibility value);
 		/// @return Size of the frame queue.
 		int getPrecachedFramesCount() const;
 		/// @brief Resizes the frame queue.
@@ -137,11 +214,77 @@ namespace theoraplayer
 		void setPrecachedFramesCount(int count);
 		/// @return Number of ready frames in the frame queue.
 		int getReadyFramesCount() const;
+		/// @return Current post-processing (deblocking/deringing) level.
+		inline int getPostProcessingLevel() const { return this->postProcessingLevel; }
+		/// @brief Sets the post-processing level. Higher levels look better, but take more time to decode.
+		/// @note The value is clamped to [0, getMaxPostProcessingLevel()]. This turns off automatic post-processing.
+		void setPostProcessingLevel(int value);
+		/// @return The highest post-processing level the decoder supports (0 if it doesn't support post-processing).
+		inline int getMaxPostProcessingLevel() const { return this->maxPostProcessingLevel; }
+		inline bool isAutoPostProcessing() const { return this->autoPostProcessing; }
+		/// @brief Whether Manager should lower the post-processing level when the clip falls behind and raise it again when there is headroom.
+		void setAutoPostProcessing(bool value);
+		/// @return Number of frames of the next iteration that are decoded ahead of time in auto-restarting clips.
+		inline int getPrerollFramesCount() const { return this->prerollFramesCount; }
+		/// @brief Sets how many frames of the next iteration a second decoder prepares while an auto-restarting clip approaches its end.
+		/// Pre-rolled frames are handed to the frame queue at the loop transition, so looping doesn't stall while the decoder restarts.
+		/// They are decoded by worker threads that have no other frames to decode.
+		/// @note 0 disables pre-rolling. Clips with audio, clips whose DataSource can't be cloned and decoders that don't support
+		/// pre-rolling restart the regular way.
+		void setPrerollFramesCount(int value);
+		/// @return Memory limit in bytes for the loop cache.
+		inline int64_t getLoopCacheMemoryLimit() const { return this->loopCacheMemoryLimit; }
+		/// @brief Sets the memory limit in bytes for the loop cache. If all converted frames of an auto-restarting clip fit into it,
+		/// the first iteration stores them and all following iterations are served from memory without decoding.
+		/// @note 0 disables the loop cache. Changing the limit or the output mode discards cached frames. Clips with audio aren't cached.
+		void setLoopCacheMemoryLimit(int64_t value);
+		/// @return Whether all frames of the clip are in the loop cache.
+		bool isLoopCached() const;
+		inline bool isIncrementalConversion() const { return this->incrementalConversion; }
+		/// @brief Sets whether only the macroblocks that changed since the picture a frame buffer already holds are converted. Frames also
+		/// report the macroblocks that changed since the previous frame, see VideoFrame::getDirtyMacroblocks(), so consumers can update
+		/// only those regions. This pays off with mostly static content.
+		/// @note Decoders that don't track changed macroblocks and clips with an alpha channel always convert the whole picture.
+		void setIncrementalConversion(bool value);
+		/// @return Pitch in bytes of the buffers set with setOutputBuffers(), 0 if none are set.
+		inline int getOutputBuffersPitch() const { return this->outputBuffersPitch; }
+		/// @brief Makes frames convert straight into buffers supplied by the caller, eg. mapped pixel buffer objects or shared memory
+		/// slots, instead of into buffers of their own that have to be copied before they can be used. A frame takes a free buffer
+		/// when the decoder starts on it and gives it back once it's popped or discarded, calling releaseCallback.
+		/// @param[in] buffers Buffers that hold getHeight() rows of pitch bytes each.
+		/// @param[in] pitch Bytes from the start of one row to the next, a multiple of the pixel size of the output mode with room for getWidth() pixels.
+		/// @param[in] releaseCallback Called once a frame is done with a buffer, can be NULL.
+		/// @param[in] userData Passed to releaseCallback.
+		/// @note Frames use their own buffers while all output buffers are taken or if the pitch doesn't fit the output mode. Buffers that
+		/// frames still hold when the pool is replaced are released as usual but not reused. An empty pool stops using output buffers.
+		/// The callback is called with the frame queue locked, so it mustn't call back into the clip.
+		void setOutputBuffers(const std::vector<unsigned char*>& buffers, int pitch, void (*releaseCallback)(VideoClip* clip, unsigned char* buffer, void* userData) = NULL,
+			void* userData = NULL);
+		/// @return Number of frames between decoder state checkpoints.
+		inline int getCheckpointInterval() const { return this->checkpointInterval; }
+		/// @brief Sets how often the decoder saves its state while decoding. A frame-accurate seek restores the nearest checkpoint
+		/// before the target frame instead of decoding from the preceding key frame, so it decodes at most this many frames.
+		/// @note 0 disables checkpoints and discards existing ones. Decoders that don't support checkpoints ignore this.
+		void setCheckpointInterval(int value);
+		/// @return Memory limit in bytes for decoder state checkpoints.
+		inline int64_t getCheckpointMemoryLimit() const { return this->checkpointMemoryLimit; }
+		/// @brief Sets the memory limit in bytes for decoder state checkpoints. When a new checkpoint doesn't fit, the checkpoints
+		/// farthest away from it are discarded.
+		void setCheckpointMemoryLimit(int64_t value);
+		/// @return Time in seconds a scrub target has to stay the same before the exact frame is decoded.
+		inline float getScrubRefineDelay() const { return this->scrubRefineDelay; }
+		void setScrubRefineDelay(float value);
+		/// @return Whether the clip shows a scrubbing preview that hasn't been refined to the exact frame yet.
+		inline bool isScrubbing() const { return (this->scrubTargetFrame >= 0); }
 		/// @brief Used for benchmarking.
 		inline int getDisplayedFramesCount() const { return this->displayedFramesCount; }
 		/// @brief Used for benchmarking.
 		inline int getDroppedFramesCount() const { return this->droppedFramesCount; }
 
+		/// @return True once the headers were read and the first frame was decoded. Clips created with Manager::createVideoClipAsync() can't be played before that.
+		inline bool isLoaded() const { return this->loaded; }
+		/// @return True if loading a clip created with Manager::createVideoClipAsync() failed.
+		inline bool hasLoadFailed() const { return this->loadFailed; }
 		bool isDone() const;
 		bool isPaused() const;
 
@@ -157,6 +300,25 @@ namespace theoraplayer
 		/// @brief Pops the frame from the front of the frame queue.
 		/// @see FrameQueue::pop()
 		void popFrame();
+		/// @brief Leases a frame returned by fetchNextFrame() so it stays valid after it's popped or the frame queue is cleared or resized,
+		/// eg. while it's uploaded asynchronously. Decoding continues in a spare frame in the meantime.
+		/// @see FrameQueue::acquire()
+		void acquireFrame(VideoFrame* frame);
+		/// @brief Gives back a frame leased with acquireFrame().
+		/// @see FrameQueue::release()
+		void releaseFrame(VideoFrame* frame);
+		/// @brief Sets a function that Manager::update() calls with every frame of the clip once it's due, instead of polling the clip
+		/// with fetchNextFrame() every tick. The frame is popped once the callback returns, it has to be leased with acquireFrame() to be
+		/// used after that.
+		/// @param[in] callback Called with the frame and the time it has to be displayed at, NULL goes back to polling.
+		/// @param[in] userData Passed to callback.
+		/// @note Only clips whose next frame is due cost work in Manager::update(). Clips destroyed by the callback are deleted once update() is done with them.
+		/// @see Manager::getClipsWithDueFrames()
+		void setFrameCallback(void (*callback)(VideoClip* clip, VideoFrame* frame, float timeToDisplay, void* userData), void* userData = NULL);
+		/// @brief Creates a view that reads the frames of this clip with its own read cursor, so the clip can be shown in several places without decoding it again.
+		/// @note Frames are reused only once the clip and all of its views popped them, so frames still have to be popped from the clip itself as well.
+		VideoClipView* createView();
+		void destroyView(VideoClipView* view);
 
 		void play();
 		void pause();
@@ -167,6 +329,12 @@ namespace theoraplayer
 		void seek(float time);
 		/// @brief Seeks to a given frame number
 		void seekToFrame(int frame);
+		/// @brief Seeks while the user drags a timeline. Calls that arrive before the previous one was handled replace its target.
+		/// The key frame before the target is shown right away and the exact frame is decoded once the target stays the same for
+		/// getScrubRefineDelay() seconds.
+		void scrub(float time);
+		/// @brief Same as scrub(), but takes a frame number.
+		void scrubToFrame(int frame);
 		/// @brief Waits for the clip to cache a given ratio of frames.
 		/// @param[in] desiredCacheRatio The ratio of precached frames to wait for.
 		/// @param[in] maxWaitTime in range [0,1]. Returns actual precache factor
@@ -176,11 +344,16 @@ namespace theoraplayer
 	protected:
 		std::string name;
 		FrameQueue* frameQueue;
+		/// @brief Number of frames from the front of the frame queue the clip already popped, only above 0 while views still need these frames.
+		int frameOffset;
+		std::vector<VideoClipView*> views;
 		AudioInterface* audioInterface;
 		DataSource* stream;
 		Timer* timer;
 		Timer* defaultTimer;
 		WorkerThread* assignedWorkerThread;
+		/// @brief Whether the assigned worker thread pre-rolls the next iteration instead of decoding the next frame.
+		bool prerolling;
 		/// @brief Syncs audio decoding and extraction.
 		Mutex* audioMutex;
 		Mutex* threadAccessMutex;
@@ -194,9 +367,61 @@ namespace theoraplayer
 		float audioGain;
 		bool autoRestart;
 		OutputMode outputMode;
+		bool dithering;
+		bool premultipliedAlpha;
+		float outputScale;
+		ScaleFilter scaleFilter;
+		bool outputCropping;
 		/// @brief User assigned priority.
 		/// @note Default value is 1.
 		float priority;
+		Visibility visibility;
+		/// @brief Requested post-processing level, applied by the decoder before decoding the next frame.
+		int postProcessingLevel;
+		int maxPostProcessingLevel;
+		bool autoPostProcessing;
+		/// @brief Used by Manager to detect newly dropped frames in automatic post-processing mode.
+		int postProcessingDroppedFramesCount;
+		/// @brief Time since the last automatic post-processing level change.
+		float postProcessingTime;
+		int prerollFramesCount;
+		int64_t loopCacheMemoryLimit;
+		/// @brief Converted frames of one iteration indexed by frame number, NULL for frames that weren't decoded yet.
+		std::vector<unsigned char*> loopCacheBuffers;
+		std::vector<float> loopCacheTimes;
+		int loopCacheFramesCount;
+		int loopCacheFrameSize;
+		OutputMode loopCacheOutputMode;
+		/// @brief Frame number of the next frame served from the loop cache, -1 while frames are decoded.
+		int loopCacheIndex;
+		/// @brief Writes decoded frames to a frame cache file, NULL if the clip isn't being cached.
+		FrameCacheWriter* frameCacheWriter;
+		bool incrementalConversion;
+		/// @brief Buffers set with setOutputBuffers().
+		std::vector<unsigned char*> outputBuffers;
+		/// @brief Output buffers that aren't held by a frame, in the order they were released.
+		std::vector<unsigned char*> freeOutputBuffers;
+		int outputBuffersPitch;
+		void (*outputBufferReleaseCallback)(VideoClip* clip, unsigned char* buffer, void* userData);
+		void* outputBufferUserData;
+		void (*frameCallback)(VideoClip* clip, VideoFrame* frame, float timeToDisplay, void* userData);
+		void* frameCallbackUserData;
+		/// @brief Whether nextFrameReady and nextFrameTime still describe the frame queue. Reset when a frame is decoded or popped.
+		bool nextFrameTimeKnown;
+		/// @brief Whether the frame queue had a frame ready for the clip when it was last checked.
+		bool nextFrameReady;
+		/// @brief Time the next ready frame has to be displayed at, including previous iterations of a looping clip.
+		float nextFrameTime;
+		int checkpointInterval;
+		int64_t checkpointMemoryLimit;
+		float keyFrameSpeedThreshold;
+		int reverseFramesBudget;
+		/// @brief Whether only key frames are decoded, set by the decoder when it executes a seek.
+		bool trickPlayKeyFrames;
+		/// @brief Whether the clip is decoded backwards, set by the decoder when it executes a seek.
+		bool trickPlayReverse;
+		bool requestedTrickPlayKeyFrames;
+		bool requestedTrickPlayReverse;
 
 		float duration;
 		float frameDuration;
@@ -215,7 +440,18 @@ namespace theoraplayer
 
 		/// @brief Contains desired seek position as a frame number. next worker thread will do the seeking and reset this var to -1
 		int seekFrame;
+		/// @brief Scrub target whose preceding key frame the next worker thread shows, -1 if there is none.
+		int scrubFrame;
+		/// @brief Scrub target that is refined to the exact frame later, -1 when not scrubbing.
+		int scrubTargetFrame;
+		float scrubRefineDelay;
+		/// @brief Time since scrubTargetFrame was last changed.
+		float scrubTime;
 		OutputMode requestedOutputMode;
+		bool loaded;
+		bool loadFailed;
+		/// @brief Set when the clip was destroyed while a thread was still using it.
+		bool retiring;
 		bool firstFrameDisplayed;
 		bool restarted;
 		int iteration;
@@ -231,6 +467,12 @@ namespace theoraplayer
 
 		bool _isBusy() const;
 		float _getAbsPlaybackTime() const;
+		/// @return Whether only key frames are decoded or the clip is decoded backwards.
+		inline bool _isTrickPlaying() const { return (this->trickPlayKeyFrames || this->trickPlayReverse); }
+		/// @brief Requests a seek to the current frame when the playback speed changes direction or crosses the key frame threshold.
+		void _updateTrickPlayMode();
+		/// @brief Called by decoders when they execute a seek to switch to the trick-play mode requested by _updateTrickPlayMode().
+		void _applyTrickPlayMode();
 
 		virtual void _load(DataSource* source) = 0;
 		virtual bool _readData() = 0;
@@ -244,11 +486,41 @@ namespace theoraplayer
 		virtual void _decodedAudioCheck() = 0;
 		/// @brief Called by WorkerThread to seek to seekFrame.
 		virtual void _executeSeek() = 0;
+		/// @brief Called by WorkerThread to show a quick preview of scrubFrame. By default this decodes the exact frame.
+		virtual void _executeScrub();
 		/// @brief Resets the decoder and stream but leaves the frame queue intact.
 		virtual void _executeRestart() = 0;
+		/// @return Whether frames of the next iteration should be decoded ahead of time. Manager assigns these to worker threads that
+		/// have nothing else to decode. By default clips aren't pre-rolled.
+		virtual bool _isPrerollPending() const;
+		/// @brief Called by WorkerThread to decode the next frame of the next iteration ahead of time.
+		virtual void _prerollNextFrame();
+		/// @brief Sets width, height, stride and the sub-frame rectangle from the decoded picture size, the output scale and cropping.
+		/// By default the size is left as it is, for decoders that can't scale.
+		virtual void _updateOutputSize();
+		/// @brief Updates the output size and recreates the frames after the scale or cropping changed.
+		void _resizeFrames();
 
 		void _resetFrameQueue();
-		int _discardOutdatedFrames(float absTime);
+		/// @brief Advances a read cursor past the frames it's too late for.
+		/// @return The number of frames skipped.
+		int _discardOutdatedFrames(float absTime, int& frameOffset);
+		/// @brief Shared implementation of fetchNextFrame() for the clip and its views.
+		VideoFrame* _fetchNextFrame(int& frameOffset, bool firstFrameDisplayed, int& droppedFramesCount);
+		/// @brief Shared implementation of getReadyFramesCount() for the clip and its views.
+		int _getReadyFramesCount(int frameOffset) const;
+		/// @brief Advances a read cursor and reuses the frames that every read cursor has passed. The frame queue has to be locked.
+		void _popFrames(int& frameOffset, int count);
+		/// @brief Moves all read cursors back to the front after the frames were discarded.
+		void _resetFrameOffsets();
+		/// @brief Used by Manager::update() to find the clips that have a frame to display without locking their frame queues. Only a
+		/// clip whose frame queue changed since it was last checked is checked again.
+		/// @return Whether the next frame of the clip is due.
+		bool _isFrameDue();
+		/// @brief Passes the frame that is due to the frame callback and pops it.
+		void _deliverFrame();
+		/// @brief Advances all read cursors past the frames that are due, so a clip that only decodes timestamps keeps going while nobody fetches its frames.
+		void _discardHiddenFrames();
 
 		void _lockAudioMutex();
 		void _unlockAudioMutex();
@@ -258,6 +530,30 @@ namespace theoraplayer
 		void _setVideoFrameInUse(VideoFrame* frame, bool value);
 		void _setVideoFrameIteration(VideoFrame* frame, int value);
 		void _setVideoFrameFrameNumber(VideoFrame* frame, int value);
+		void _setVideoFrameTimestampOnly(VideoFrame* frame, bool value);
+		/// @param[in] macroblocks The macroblocks that changed since the previous frame, NULL if the whole picture changed.
+		void _setVideoFrameDirtyMacroblocks(VideoFrame* frame, const unsigned char* macroblocks);
+		int _getVideoFramePictureSerial(VideoFrame* frame) const;
+		void _setVideoFramePictureSerial(VideoFrame* frame, int value);
+		/// @brief Exchanges the pixel buffers of two frames without copying. The picture is copied instead if the frame holds an output buffer.
+		void _swapVideoFrameBuffers(VideoFrame* frame, VideoFrame* other);
+		/// @brief Gives the frame a free output buffer if there is one that fits. The frame queue has to be locked.
+		void _attachOutputBuffer(VideoFrame* frame);
+		/// @brief Takes back an output buffer a frame is done with. The frame queue has to be locked.
+		void _releaseOutputBuffer(unsigned char* buffer);
+
+		/// @brief Called by decoders with every newly decoded frame to fill the loop cache and the frame cache file.
+		void _storeDecodedFrame(VideoFrame* frame);
+		void _storeLoopCacheFrame(VideoFrame* frame);
+		/// @brief Called by decoders when an auto-restarting clip reaches the end of the stream.
+		/// @return True if all frames are cached and following frames will be served by _fetchLoopCachedFrame().
+		bool _startLoopCachePlayback();
+		/// @brief Fills frame with the next frame from the loop cache, advancing the iteration when the end of the clip is reached.
+		/// @return False if frames aren't served from the loop cache and have to be decoded.
+		bool _fetchLoopCachedFrame(VideoFrame* frame);
+		/// @brief Continues with decoding, eg. after a seek.
+		void _stopLoopCachePlayback();
+		void _clearLoopCache();
 
 	};
 
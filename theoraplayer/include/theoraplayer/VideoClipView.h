@@ -0,0 +1,59 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a view of a video clip.
+
+#ifndef THEORAPLAYER_VIDEO_CLIP_VIEW_H
+#define THEORAPLAYER_VIDEO_CLIP_VIEW_H
+
+#include "theoraplayerExport.h"
+
+namespace theoraplayer
+{
+	class VideoClip;
+	class VideoFrame;
+
+	/// @brief Reads the frames of a clip with its own read cursor. Used to show the same clip at the same time position in several places
+	/// while it's decoded only once. Views are created with VideoClip::createView().
+	class theoraplayerExport VideoClipView
+	{
+	public:
+		friend class VideoClip;
+
+		inline VideoClip* getClip() const { return this->clip; }
+		/// @brief Used for benchmarking.
+		inline int getDisplayedFramesCount() const { return this->displayedFramesCount; }
+		/// @brief Used for benchmarking.
+		inline int getDroppedFramesCount() const { return this->droppedFramesCount; }
+
+		/// @return The number of frames this view hasn't popped yet.
+		int getReadyFramesCount() const;
+		/// @return The frame to display at the clip's current time position or NULL if it's not ready yet.
+		/// @see VideoClip::fetchNextFrame()
+		VideoFrame* fetchNextFrame();
+		/// @brief Marks the frame as displayed by this view. The frame is reused once every view and the clip itself popped it.
+		/// @see VideoClip::popFrame()
+		void popFrame();
+
+	protected:
+		VideoClip* clip;
+		/// @brief Number of frames from the front of the frame queue this view already popped.
+		int frameOffset;
+		bool firstFrameDisplayed;
+		int displayedFramesCount;
+		int droppedFramesCount;
+
+		VideoClipView(VideoClip* clip);
+		~VideoClipView();
+
+	};
+
+}
+#endif
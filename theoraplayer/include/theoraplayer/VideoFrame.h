@@ -34,6 +34,10 @@ namespace theoraplayer
 		virtual ~VideoFrame();
 
 		inline unsigned char* getBuffer() const { return this->buffer; }
+		/// @return Bytes from the start of one row of the buffer to the next.
+		inline int getPitch() const { return this->pitch; }
+		/// @return Whether the buffer is one of the buffers set with VideoClip::setOutputBuffers() instead of the frame's own one.
+		inline bool hasOutputBuffer() const { return (this->buffer != this->ownBuffer); }
 		inline unsigned long getFrameNumber() const { return this->frameNumber; }
 		int getWidth() const;
 		int getStride() const;
@@ -44,9 +48,24 @@ namespace theoraplayer
 
 		//! Called by VideoClip to decode a source buffer onto itself
 		virtual void decode(struct Theoraplayer_PixelTransform* t);
+		/// @brief Called by VideoClip to decode only the given macroblocks of a source buffer onto itself, the rest of the buffer is kept.
+		/// @param[in] macroblocks One byte per 16x16 pixel block, row by row, that isn't 0 for the blocks that are decoded.
+		void decodeMacroblocks(struct Theoraplayer_PixelTransform* t, const unsigned char* macroblocks);
+		/// @return One byte per 16x16 pixel block of the frame, row by row, that isn't 0 where the picture differs from the frame that was
+		/// put into the frame queue before this one. NULL if the whole picture has to be treated as changed.
+		/// @note Only reported if VideoClip::setIncrementalConversion() is enabled. A consumer that didn't show the previous frame, eg. because
+		/// it was dropped, has to treat the whole picture as changed as well.
+		inline const unsigned char* getDirtyMacroblocks() const { return (this->hasDirtyMacroblocks ? this->dirtyMacroblocks : NULL); }
+		/// @return Number of 16x16 pixel blocks in a row of the frame.
+		int getMacroblocksCountX() const;
+		/// @return Number of rows of 16x16 pixel blocks in the frame.
+		int getMacroblocksCountY() const;
 		
 		bool isReady() const { return this->ready; }
 		bool isInUse() const { return this->inUse; }
+		/// @return Number of leases held on the frame.
+		/// @see FrameQueue::acquire()
+		int getLeasesCount() const { return this->leasesCount; }
 		float getTimeToDisplay() const { return this->timeToDisplay; }
 
 		void clearInUseFlag() { this->inUse = false; }
@@ -60,16 +79,42 @@ namespace theoraplayer
 		bool ready;
 		/// @brief Indicates the frame is being used by TheoraWorkerThread instance.
 		bool inUse;
+		/// @brief Number of leases held by consumers, the frame isn't reused while it's leased.
+		int leasesCount;
 		/// @brief Used to keep track of linear time in looping videos.
 		int iteration;
+		/// @brief Whether only the timing of the frame was decoded and the buffer doesn't hold its picture.
+		bool timestampOnly;
 		/// @brief Bytes per pixel.
 		int bpp;
 		/// @brief The VideoClip.
 		VideoClip* clip;
 		/// @brief Current buffer.
 		unsigned char* buffer;
+		/// @brief Buffer allocated by the frame, used while no output buffer is attached.
+		unsigned char* ownBuffer;
+		/// @brief Bytes per row of the current buffer.
+		int pitch;
 		/// @brief Current frame number.
 		unsigned long frameNumber;
+		unsigned char* dirtyMacroblocks;
+		bool hasDirtyMacroblocks;
+		/// @brief Number assigned by the decoder to the picture the buffer holds, used for incremental conversion. -1 if unknown.
+		int pictureSerial;
+
+		/// @return Bytes per row of the frame's own buffer.
+		int _getOwnPitch() const;
+		/// @brief Makes the frame use a buffer set with VideoClip::setOutputBuffers() until it's cleared.
+		void _attachOutputBuffer(unsigned char* buffer, int pitch);
+		/// @brief Hands the output buffer back to the clip and goes back to the frame's own buffer.
+		void _detachOutputBuffer();
+		/// @brief Converts a picture with an alpha channel in 16x16 pixel blocks, blocks that are fully transparent aren't converted and are
+		/// cleared to 0 instead.
+		void _decodeVisibleBlocks(struct Theoraplayer_PixelTransform* t);
+		/// @brief Copies a picture with the given pitch into the buffer.
+		void _copyPictureFrom(const unsigned char* source, int sourcePitch);
+		/// @brief Copies the picture in the buffer to memory with the given pitch.
+		void _copyPictureTo(unsigned char* destination, int destinationPitch) const;
 
 	};
 
@@ -18,4 +18,14 @@ namespace theoraplayer
 	{
 	}
 
+	DataSource* DataSource::clone()
+	{
+		return NULL;
+	}
+
+	std::string DataSource::getAssetId() const
+	{
+		return "";
+	}
+
 }
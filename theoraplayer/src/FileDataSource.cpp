@@ -91,6 +91,11 @@ namespace theoraplayer
 		fsetpos(this->filePtr, &fpos);
 	}
 
+	DataSource* FileDataSource::clone()
+	{
+		return new FileDataSource(this->filename);
+	}
+
 	int64_t FileDataSource::getSize()
 	{
 		if (this->filePtr == NULL)
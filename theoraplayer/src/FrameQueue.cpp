@@ -6,6 +6,8 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <algorithm>
+
 #include "Manager.h"
 
 #include "FrameQueue.h"
@@ -17,7 +19,7 @@
 
 namespace theoraplayer
 {
-	FrameQueue::FrameQueue(VideoClip* parent) : mutex(new Mutex())
+	FrameQueue::FrameQueue(VideoClip* parent) : size(0), mutex(new Mutex())
 	{
 		this->parent = parent;
 	}
@@ -30,6 +32,18 @@ namespace theoraplayer
 			delete (*it);
 		}
 		this->queue.clear();
+		foreach_l (VideoFrame*, it, this->leasedFrames)
+		{
+			delete (*it);
+		}
+		foreach_l (VideoFrame*, it, this->retiredFrames)
+		{
+			delete (*it);
+		}
+		foreach_l (VideoFrame*, it, this->spareFrames)
+		{
+			delete (*it);
+		}
 		delete this->mutex;
 	}
 
@@ -44,6 +58,17 @@ namespace theoraplayer
 		return frame;
 	}
 
+	VideoFrame* FrameQueue::_getSpareFrame()
+	{
+		if (this->spareFrames.size() == 0)
+		{
+			return this->_createFrameInstance(this->parent);
+		}
+		VideoFrame* frame = this->spareFrames.back();
+		this->spareFrames.pop_back();
+		return frame;
+	}
+
 	int FrameQueue::getUsedCount() const
 	{
 		Mutex::ScopeLock lock(this->mutex);
@@ -70,6 +95,19 @@ namespace theoraplayer
 		return (frame->ready ? frame : NULL);
 	}
 
+	VideoFrame* FrameQueue::_getAvailableFrame(int index) const
+	{
+		foreachc_l (VideoFrame*, it, this->queue)
+		{
+			if (index == 0)
+			{
+				return ((*it)->ready ? (*it) : NULL);
+			}
+			--index;
+		}
+		return NULL;
+	}
+
 	int FrameQueue::getReadyCount()
 	{
 		Mutex::ScopeLock lock(this->mutex);
@@ -101,10 +139,25 @@ namespace theoraplayer
 		{
 			foreach_l (VideoFrame*, it, this->queue)
 			{
-				delete (*it);
+				if ((*it)->leasesCount > 0)
+				{
+					this->retiredFrames.push_back(*it);
+				}
+				else
+				{
+					delete (*it);
+				}
 			}
 			this->queue.clear();
 		}
+		// frames leased before can't be reused, the clip's output might have changed
+		this->retiredFrames.splice(this->retiredFrames.end(), this->leasedFrames);
+		foreach_l (VideoFrame*, it, this->spareFrames)
+		{
+			delete (*it);
+		}
+		this->spareFrames.clear();
+		this->size = n;
 		VideoFrame* frame = NULL;
 		for (int i = 0; i < n; ++i)
 		{
@@ -131,9 +184,28 @@ namespace theoraplayer
 	void FrameQueue::clear()
 	{
 		Mutex::ScopeLock lock(this->mutex);
-		foreach_l (VideoFrame*, it, this->queue)
+		this->_clear();
+	}
+
+	void FrameQueue::_clear()
+	{
+		VideoFrame* spare = NULL;
+		std::list<VideoFrame*>::iterator it = this->queue.begin();
+		while (it != this->queue.end())
 		{
+			if ((*it)->leasesCount > 0)
+			{
+				this->leasedFrames.push_back(*it);
+				spare = this->_getSpareFrame();
+				if (spare == NULL)
+				{
+					it = this->queue.erase(it);
+					continue;
+				}
+				(*it) = spare;
+			}
 			(*it)->clear();
+			++it;
 		}
 	}
 
@@ -149,12 +221,64 @@ namespace theoraplayer
 		for (int i = 0; i < n; ++i)
 		{
 			first = this->queue.front();
-			first->clear();
 			this->queue.pop_front();
+			if (first->leasesCount > 0)
+			{
+				// the consumer keeps the frame, the decoder continues in a spare one
+				this->leasedFrames.push_back(first);
+				first = this->_getSpareFrame();
+				if (first == NULL)
+				{
+					continue;
+				}
+			}
+			first->clear();
 			this->queue.push_back(first);
 		}
 	}
 
+	void FrameQueue::acquire(VideoFrame* frame)
+	{
+		Mutex::ScopeLock lock(this->mutex);
+		++frame->leasesCount;
+	}
+
+	void FrameQueue::release(VideoFrame* frame)
+	{
+		Mutex::ScopeLock lock(this->mutex);
+		if (frame->leasesCount <= 0)
+		{
+			return;
+		}
+		--frame->leasesCount;
+		if (frame->leasesCount > 0)
+		{
+			return;
+		}
+		std::list<VideoFrame*>::iterator it = std::find(this->retiredFrames.begin(), this->retiredFrames.end(), frame);
+		if (it != this->retiredFrames.end())
+		{
+			this->retiredFrames.erase(it);
+			delete frame;
+			return;
+		}
+		it = std::find(this->leasedFrames.begin(), this->leasedFrames.end(), frame);
+		if (it == this->leasedFrames.end())
+		{
+			return; // still in the queue
+		}
+		this->leasedFrames.erase(it);
+		frame->clear();
+		if ((int)this->queue.size() < this->size) // a spare frame couldn't be created when the frame left the queue
+		{
+			this->queue.push_back(frame);
+		}
+		else
+		{
+			this->spareFrames.push_back(frame);
+		}
+	}
+
 	VideoFrame* FrameQueue::requestEmptyFrame()
 	{
 		Mutex::ScopeLock lock(this->mutex);
@@ -164,6 +288,10 @@ namespace theoraplayer
 			{
 				(*it)->inUse = true;
 				(*it)->ready = false;
+				if (!(*it)->hasOutputBuffer())
+				{
+					this->parent->_attachOutputBuffer(*it);
+				}
 				return (*it);
 			}
 		}
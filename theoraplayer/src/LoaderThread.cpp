@@ -0,0 +1,55 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "Exception.h"
+#include "LoaderThread.h"
+#include "Manager.h"
+#include "Mutex.h"
+#include "theoraplayer.h"
+#include "VideoClip.h"
+
+namespace theoraplayer
+{
+	LoaderThread::LoaderThread(VideoClip* clip, DataSource* dataSource, void (*callback)(VideoClip*, bool)) : Thread(&LoaderThread::_work)
+	{
+		this->clip = clip;
+		this->dataSource = dataSource;
+		this->callback = callback;
+	}
+
+	LoaderThread::~LoaderThread()
+	{
+	}
+
+	void LoaderThread::_work(Thread* thread)
+	{
+		LoaderThread* self = (LoaderThread*)thread;
+		bool loaded = true;
+		try
+		{
+			// the clip isn't handed to worker threads before it's loaded so it's safe to load it without holding any locks
+			theoraplayer::manager->_loadVideoClip(self->clip, self->dataSource, NULL);
+		}
+		catch (_Exception& e)
+		{
+			log("ERROR: Failed loading video clip: " + e.getMessage());
+			loaded = false;
+		}
+		Mutex::ScopeLock lock(theoraplayer::manager->workMutex);
+		if (loaded)
+		{
+			self->clip->loaded = true;
+		}
+		else
+		{
+			self->clip->loadFailed = true;
+		}
+		lock.release();
+	}
+
+}
@@ -0,0 +1,47 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a loader thread.
+
+#ifndef THEORAPLAYER_LOADER_THREAD_H
+#define THEORAPLAYER_LOADER_THREAD_H
+
+#include "Thread.h"
+
+namespace theoraplayer
+{
+	class DataSource;
+	class VideoClip;
+
+	/**
+		This is the loader thread, loads a single VideoClip created with
+		VideoManager::createVideoClipAsync and exits
+	*/
+	class LoaderThread : public Thread
+	{
+	public:
+		LoaderThread(VideoClip* clip, DataSource* dataSource, void (*callback)(VideoClip*, bool));
+		~LoaderThread();
+
+		inline VideoClip* getClip() const { return this->clip; }
+		inline void (*getCallback())(VideoClip*, bool) { return this->callback; }
+
+	protected:
+		VideoClip* clip;
+		DataSource* dataSource;
+		/// @brief Called by Manager::update() once loading is done.
+		void (*callback)(VideoClip*, bool);
+
+		static void _work(Thread* thread);
+
+	};
+
+}
+#endif
@@ -15,10 +15,16 @@
 #endif
 #endif
 
+#include <math.h>
+
 #include "AudioInterface.h"
 #include "FileDataSource.h"
 #include "Exception.h"
+#include "FrameCache/FrameCacheWriter.h"
+#include "FrameCache/VideoClip_FrameCache.h"
 #include "FrameQueue.h"
+#include "LoaderThread.h"
+#include "MappedFileDataSource.h"
 #include "Manager.h"
 #include "theoraplayer.h"
 #include "Utility.h"
@@ -38,6 +44,13 @@ extern "C"
 
 //#define _DECODING_BENCHMARK //uncomment to test average decoding time on a given device
 
+// automatic post-processing: minimum time between two steps down (so the decoder can catch up after each one)
+// and time the clip has to keep up with at least half of its frame queue full before stepping back up
+#define POSTPROCESSING_LOWER_DELAY 0.5f
+#define POSTPROCESSING_RAISE_DELAY 2.0f
+// clips that only decode timestamps get this share of the time a visible clip with the same priority gets
+#define TIMESTAMPS_ONLY_PRIORITY_FACTOR 0.25f
+
 namespace theoraplayer
 {
 #ifdef _SCHEDULING_DEBUG
@@ -105,12 +118,23 @@ namespace theoraplayer
 	Manager::~Manager()
 	{
 		this->_destroyWorkerThreads();
+		foreach (LoaderThread*, it, this->loaderThreads)
+		{
+			(*it)->join();
+			delete (*it);
+		}
+		this->loaderThreads.clear();
 		Mutex::ScopeLock lock(this->workMutex);
 		foreach (VideoClip*, it, this->clips)
 		{
 			delete (*it);
 		}
 		this->clips.clear();
+		foreach (VideoClip*, it, this->retiringClips)
+		{
+			delete (*it);
+		}
+		this->retiringClips.clear();
 		lock.release();
 		delete this->workMutex;
 	}
@@ -192,8 +216,88 @@ namespace theoraplayer
 
 	VideoClip* Manager::createVideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride)
 	{
+		return this->_createVideoClip(dataSource, outputMode, precachedFramesCountOverride, usePotStride, NULL);
+	}
+
+	VideoClip* Manager::createCachedVideoClip(const std::string& filename, const std::string& cacheFilename, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride)
+	{
+		DataSource* dataSource = new FileDataSource(filename);
+		uint64_t hash = 0;
+		try
+		{
+			hash = VideoClip_FrameCache::calculateHash(dataSource);
+		}
+		catch (_Exception& e)
+		{
+			delete dataSource;
+			throw e;
+		}
+		if (VideoClip_FrameCache::isValid(cacheFilename, hash, outputMode, usePotStride))
+		{
+			delete dataSource;
+			return this->_createVideoClip(new MappedFileDataSource(cacheFilename, FRAME_CACHE_FORMAT_NAME), outputMode, precachedFramesCountOverride, usePotStride, NULL);
+		}
+		return this->_createVideoClip(dataSource, outputMode, precachedFramesCountOverride, usePotStride, new FrameCacheWriter(cacheFilename, hash, usePotStride));
+	}
+
+	VideoClip* Manager::createVideoClipAsync(const std::string& filename, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride, void (*callback)(VideoClip* clip, bool success))
+	{
+		return this->createVideoClipAsync(new FileDataSource(filename), outputMode, precachedFramesCountOverride, usePotStride, callback);
+	}
+
+	VideoClip* Manager::createVideoClipAsync(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride, void (*callback)(VideoClip* clip, bool success))
+	{
+		VideoClip* clip = this->_instantiateVideoClip(dataSource, outputMode, precachedFramesCountOverride, usePotStride);
+		if (clip == NULL)
+		{
+			log("ERROR: Failed creating video clip: " + dataSource->toString());
+			return NULL;
+		}
+		// the clip is registered right away, but worker threads skip it until it's loaded
+		Mutex::ScopeLock lock(this->workMutex);
+		this->clips.push_back(clip);
+		LoaderThread* thread = new LoaderThread(clip, dataSource, callback);
+		this->loaderThreads.push_back(thread);
+		thread->start();
+		lock.release();
+		return clip;
+	}
+
+	VideoClip* Manager::_createVideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride, FrameCacheWriter* frameCacheWriter)
+	{
+		VideoClip* clip = this->_instantiateVideoClip(dataSource, outputMode, precachedFramesCountOverride, usePotStride);
+		if (clip == NULL)
+		{
+			log("ERROR: Failed creating video clip: " + dataSource->toString());
+			if (frameCacheWriter != NULL)
+			{
+				delete frameCacheWriter;
+			}
+			return NULL;
+		}
+		try
+		{
+			// loading doesn't hold workMutex so worker threads keep decoding other clips in the meantime
+			this->_loadVideoClip(clip, dataSource, frameCacheWriter);
+		}
+		catch (_Exception& e)
+		{
+			delete clip;
+			// don't delete dataSource, it should be deleted by the calling function
+			throw e;
+		}
 		Mutex::ScopeLock lock(this->workMutex);
-		VideoClip* clip = NULL;
+		clip->loaded = true;
+		this->clips.push_back(clip);
+		lock.release();
+#ifdef _DECODING_BENCHMARK
+		benchmark(clip);
+#endif
+		return clip;
+	}
+
+	VideoClip* Manager::_instantiateVideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCountOverride, bool usePotStride)
+	{
 		int precachedFramesCount = (precachedFramesCountOverride > 0 ? precachedFramesCountOverride : this->defaultPrecachedFramesCount);
 		log("Creating video from data source: " + dataSource->toString() + " [" + str(precachedFramesCount) + " precached frames].");
 		std::string formatName = dataSource->getFormatName();
@@ -203,35 +307,29 @@ namespace theoraplayer
 			{
 				if (formatName == (*it).name)
 				{
-					clip = (*(*it).createFunction)(dataSource, outputMode, precachedFramesCount, usePotStride);
-					break;
+					return (*(*it).createFunction)(dataSource, outputMode, precachedFramesCount, usePotStride);
 				}
 			}
 		}
-		if (clip != NULL)
+		return NULL;
+	}
+
+	void Manager::_loadVideoClip(VideoClip* clip, DataSource* dataSource, FrameCacheWriter* frameCacheWriter)
+	{
+		try
 		{
-			try
-			{
-				clip->_load(dataSource);
-			}
-			catch (_Exception& e)
-			{
-				delete clip;
-				// don't delete dataSource, it should be deleted by the calling function
-				throw e;
-			}
-			clip->_decodeNextFrame(); // ensure the first frame is always preloaded and have the main thread do it to prevent potential thread starvation
-			this->clips.push_back(clip);
+			clip->_load(dataSource);
 		}
-		else
+		catch (_Exception& e)
 		{
-			log("ERROR: Failed creating video clip: " + dataSource->toString());
+			if (frameCacheWriter != NULL)
+			{
+				delete frameCacheWriter;
+			}
+			throw e;
 		}
-		lock.release();
-#ifdef _DECODING_BENCHMARK
-		benchmark(clip);
-#endif
-		return clip;
+		clip->frameCacheWriter = frameCacheWriter; // set before decoding so the first frame is stored as well
+		clip->_decodeNextFrame(); // ensure the first frame is always preloaded and have the loading thread do it to prevent potential thread starvation
 	}
 
 	void Manager::destroyVideoClip(VideoClip* clip)
@@ -242,30 +340,45 @@ namespace theoraplayer
 		}
 		log("Destroying video clip: " + clip->getName());
 		Mutex::ScopeLock lock(this->workMutex);
-		bool reported = false;
-		while (clip->assignedWorkerThread != NULL)
+		foreach (VideoClip*, it, this->clips)
 		{
-			if (!reported)
+			if ((*it) == clip)
 			{
-				log(" - Waiting for WorkerThread to finish decoding in order to destroy");
-				reported = true;
+				this->clips.erase(it);
+				break;
 			}
-			Thread::sleep(1.0f);
 		}
-		if (reported)
+		// remove all it's references from the work log
+		this->workLog.remove(clip);
+		foreach (VideoClip*, it, this->dueClips)
 		{
-			log(" - WorkerThread done, destroying clip now...");
+			if ((*it) == clip)
+			{
+				this->dueClips.erase(it);
+				break;
+			}
 		}
-		foreach (VideoClip*, it, this->clips)
+		bool loading = false;
+		foreach (LoaderThread*, it, this->loaderThreads)
 		{
-			if ((*it) == clip)
+			if ((*it)->getClip() == clip)
 			{
-				this->clips.erase(it);
+				loading = true;
 				break;
 			}
 		}
-		// remove all it's references from the work log
-		this->workLog.remove(clip);
+		bool callbackPending = this->_isCallbackPending(clip);
+		if (loading || callbackPending || clip->assignedWorkerThread != NULL)
+		{
+			// the thread using the clip deletes it when it's done, update() does it for loader threads and pending callbacks
+			clip->retiring = true;
+			this->retiringClips.push_back(clip);
+#ifdef _DEBUG
+			log(" - Clip is in use by a " + std::string(loading ? "LoaderThread" : (callbackPending ? "pending callback" : "WorkerThread")) + ", it will be destroyed once it's done.");
+#endif
+			return;
+		}
+		lock.release();
 		// delete the actual clip
 		delete clip;
 #ifdef _DEBUG
@@ -276,12 +389,87 @@ namespace theoraplayer
 	void Manager::update(float timeDelta)
 	{
 		Mutex::ScopeLock lock(this->workMutex);
+		LoaderThreadList finishedLoaderThreads;
+		for (int i = 0; i < (int)this->loaderThreads.size(); ++i)
+		{
+			if (!this->loaderThreads[i]->isRunning())
+			{
+				finishedLoaderThreads.push_back(this->loaderThreads[i]);
+				this->callbackClips.push_back(this->loaderThreads[i]->getClip());
+				this->loaderThreads.erase(this->loaderThreads.begin() + i);
+				--i;
+			}
+		}
+		ClipList deliveredClips;
+		this->dueClips.clear();
 		foreach (VideoClip*, it, this->clips)
 		{
+			if (!(*it)->loaded)
+			{
+				continue;
+			}
 			(*it)->update(timeDelta);
 			(*it)->_decodedAudioCheck();
+			this->_updatePostProcessing((*it), timeDelta);
+			if ((*it)->_isFrameDue())
+			{
+				if ((*it)->frameCallback != NULL)
+				{
+					deliveredClips.push_back(*it);
+					if (!this->_isCallbackPending(*it)) // its loader may have finished in this update as well
+					{
+						this->callbackClips.push_back(*it);
+					}
+				}
+				else
+				{
+					this->dueClips.push_back(*it);
+				}
+			}
 		}
 		lock.release();
+		// frames are delivered without holding workMutex so the callbacks can work with the clips
+		bool retiring = false;
+		foreach (VideoClip*, it, deliveredClips)
+		{
+			lock.acquire(this->workMutex);
+			retiring = (*it)->retiring; // destroyed by one of the previous callbacks
+			lock.release();
+			if (!retiring)
+			{
+				(*it)->_deliverFrame();
+			}
+		}
+		// callbacks are called without holding workMutex so they can create or destroy clips
+		foreach (LoaderThread*, it, finishedLoaderThreads)
+		{
+			(*it)->join();
+			lock.acquire(this->workMutex);
+			retiring = (*it)->getClip()->retiring; // destroyed while it was loading or by one of the previous callbacks
+			lock.release();
+			if (!retiring && (*it)->getCallback() != NULL)
+			{
+				(*(*it)->getCallback())((*it)->getClip(), (*it)->getClip()->isLoaded());
+			}
+			delete (*it);
+		}
+		// clips destroyed while a callback was pending are deleted once no callback can reach them anymore
+		ClipList destroyedClips;
+		lock.acquire(this->workMutex);
+		foreach (VideoClip*, it, this->callbackClips)
+		{
+			if ((*it)->retiring && (*it)->assignedWorkerThread == NULL)
+			{
+				this->_removeRetiringClip(*it);
+				destroyedClips.push_back(*it);
+			}
+		}
+		this->callbackClips.clear();
+		lock.release();
+		foreach (VideoClip*, it, destroyedClips)
+		{
+			delete (*it);
+		}
 #ifdef _SCHEDULING_DEBUG
 		threadDiagnosticTimer += timeDelta;
 #endif
@@ -321,6 +509,104 @@ namespace theoraplayer
 		}
 	}
 
+	void Manager::_updatePostProcessing(VideoClip* clip, float timeDelta)
+	{
+		bool dropped = (clip->droppedFramesCount > clip->postProcessingDroppedFramesCount);
+		clip->postProcessingDroppedFramesCount = clip->droppedFramesCount;
+		if (!clip->autoPostProcessing || clip->maxPostProcessingLevel == 0 || clip->isPaused() || clip->isDone())
+		{
+			return;
+		}
+		clip->postProcessingTime += timeDelta;
+		int readyFramesCount = clip->getReadyFramesCount();
+		if (dropped || (readyFramesCount == 0 && clip->firstFrameDisplayed))
+		{
+			if (clip->postProcessingLevel > 0 && clip->postProcessingTime >= POSTPROCESSING_LOWER_DELAY)
+			{
+				--clip->postProcessingLevel;
+				clip->postProcessingTime = 0.0f;
+#ifdef _DEBUG
+				log(clip->name + ": falling behind, lowering post-processing level to " + str(clip->postProcessingLevel));
+#endif
+			}
+		}
+		else if (readyFramesCount * 2 < clip->getPrecachedFramesCount())
+		{
+			// not enough headroom to step up, but don't delay stepping down either
+			if (clip->postProcessingTime > POSTPROCESSING_LOWER_DELAY)
+			{
+				clip->postProcessingTime = POSTPROCESSING_LOWER_DELAY;
+			}
+		}
+		else if (clip->postProcessingLevel < clip->maxPostProcessingLevel && clip->postProcessingTime >= POSTPROCESSING_RAISE_DELAY)
+		{
+			++clip->postProcessingLevel;
+			clip->postProcessingTime = 0.0f;
+#ifdef _DEBUG
+			log(clip->name + ": raising post-processing level to " + str(clip->postProcessingLevel));
+#endif
+		}
+	}
+
+	bool Manager::_finishWork(WorkerThread* caller, bool decoded)
+	{
+		Mutex::ScopeLock lock(this->workMutex);
+		VideoClip* clip = caller->getAssignedClip();
+		if (clip->assignedWorkerThread == caller)
+		{
+			clip->assignedWorkerThread = NULL;
+			clip->prerolling = false;
+		}
+		if (decoded)
+		{
+			clip->nextFrameTimeKnown = false;
+		}
+		// update() deletes the clip if it still has to call a callback for it
+		if (clip->retiring && !this->_isCallbackPending(clip))
+		{
+			this->_removeRetiringClip(clip);
+			return true;
+		}
+		return false;
+	}
+
+	void Manager::_removeRetiringClip(VideoClip* clip)
+	{
+		foreach (VideoClip*, it, this->retiringClips)
+		{
+			if ((*it) == clip)
+			{
+				this->retiringClips.erase(it);
+				break;
+			}
+		}
+	}
+
+	bool Manager::_isCallbackPending(VideoClip* clip)
+	{
+		foreach (VideoClip*, it, this->callbackClips)
+		{
+			if ((*it) == clip)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool Manager::_hasScrubbingClips()
+	{
+		Mutex::ScopeLock lock(this->workMutex);
+		foreach (VideoClip*, it, this->clips)
+		{
+			if ((*it)->isScrubbing())
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
 	VideoClip* Manager::_requestWork(WorkerThread* caller)
 	{
 		Mutex::ScopeLock lock(this->workMutex);
@@ -337,14 +623,21 @@ namespace theoraplayer
 		{
 			foreach (VideoClip*, it, this->clips)
 			{
-				if (!(*it)->_isBusy() && (i > 0 || (*it)->isPaused() || !(*it)->waitingForCache))
+				// clips that show a scrubbing preview have nothing to decode until the next scrub or seek, dormant clips aren't decoded at all
+				if (!(*it)->_isBusy() && (i > 0 || (*it)->isPaused() || !(*it)->waitingForCache) &&
+					((*it)->scrubTargetFrame < 0 || (*it)->scrubFrame >= 0) && (*it)->visibility != VISIBILITY_DORMANT)
 				{
 					readyFramesCount = (*it)->getReadyFramesCount();
-					if (readyFramesCount != (*it)->getFrameQueue()->getSize())
+					// frames the clip already popped but its views still need occupy the queue as well
+					if (readyFramesCount == 0 || readyFramesCount + (*it)->frameOffset != (*it)->getFrameQueue()->getSize())
 					{
 						candidate.clip = (*it);
 						candidate.priority = (*it)->getPriority();
-						candidate.queuedTime = (float)readyFramesCount / ((*it)->getFps() * (*it)->getPlaybackSpeed());
+						if ((*it)->visibility == VISIBILITY_TIMESTAMPS_ONLY)
+						{
+							candidate.priority *= TIMESTAMPS_ONLY_PRIORITY_FACTOR;
+						}
+						candidate.queuedTime = (float)readyFramesCount / ((*it)->getFps() * (float)fabs((*it)->getPlaybackSpeed())); // clips playing backwards use up frames just as fast
 						candidate.workTime = (float)(*it)->threadAccessCount;
 						totalAccessCount += (*it)->threadAccessCount;
 						if (maxQueuedTime < candidate.queuedTime)
@@ -393,6 +686,19 @@ namespace theoraplayer
 				selectedClip = it->clip;
 			}
 		}
+		// worker threads that have no frames to decode prepare the next iteration of looping clips, so pre-rolling never delays a frame
+		if (selectedClip == NULL)
+		{
+			foreach (VideoClip*, it, this->clips)
+			{
+				if (!(*it)->_isBusy() && (*it)->visibility != VISIBILITY_DORMANT && (*it)->_isPrerollPending())
+				{
+					selectedClip = (*it);
+					selectedClip->prerolling = true;
+					break;
+				}
+			}
+		}
 		if (selectedClip != NULL)
 		{
 			selectedClip->assignedWorkerThread = caller;
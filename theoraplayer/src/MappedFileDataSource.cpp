@@ -0,0 +1,207 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <memory.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#if defined(_WIN32) && !defined(_WINRT)
+#include <windows.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFileDataSource.h"
+#include "Exception.h"
+#include "Manager.h"
+#include "MemoryDataSource.h"
+#include "theoraplayer.h"
+#include "Utility.h"
+
+namespace theoraplayer
+{
+	MappedFileDataSource::MappedFileDataSource(const std::string& filename)
+	{
+		this->filename = filename;
+		this->size = 0;
+		this->position = 0;
+		this->data = NULL;
+		this->mapped = false;
+#if defined(_WIN32) && !defined(_WINRT)
+		this->fileHandle = NULL;
+		this->mappingHandle = NULL;
+#endif
+		VideoClip::Format format;
+		// used for determining the file format, does not throw an exception inside the ctor
+		FILE* file = openSupportedFormatFile(this->filename, format, this->fullFilename);
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+		this->formatName = format.name;
+	}
+
+	MappedFileDataSource::MappedFileDataSource(const std::string& filename, const std::string& formatName)
+	{
+		this->filename = filename;
+		this->fullFilename = filename;
+		this->formatName = formatName;
+		this->size = 0;
+		this->position = 0;
+		this->data = NULL;
+		this->mapped = false;
+#if defined(_WIN32) && !defined(_WINRT)
+		this->fileHandle = NULL;
+		this->mappingHandle = NULL;
+#endif
+	}
+
+	MappedFileDataSource::~MappedFileDataSource()
+	{
+#if defined(_WIN32) && !defined(_WINRT)
+		if (this->data != NULL)
+		{
+			UnmapViewOfFile(this->data);
+		}
+		if (this->mappingHandle != NULL)
+		{
+			CloseHandle((HANDLE)this->mappingHandle);
+		}
+		if (this->fileHandle != NULL)
+		{
+			CloseHandle((HANDLE)this->fileHandle);
+		}
+#elif defined(_WINRT)
+		if (this->data != NULL)
+		{
+			delete[] this->data;
+		}
+#else
+		if (this->data != NULL)
+		{
+			munmap(this->data, (size_t)this->size);
+		}
+#endif
+	}
+
+	// must not be called in the ctor, can throw exceptions
+	void MappedFileDataSource::_mapFile()
+	{
+		if (this->mapped)
+		{
+			return;
+		}
+		std::string message = "Can't open or map video file: " + this->filename;
+#if defined(_WIN32) && !defined(_WINRT)
+		HANDLE file = CreateFileA(this->fullFilename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			log(message);
+			throw TheoraplayerException(message);
+		}
+		LARGE_INTEGER fileSize;
+		GetFileSizeEx(file, &fileSize);
+		this->size = (int64_t)fileSize.QuadPart;
+		if (this->size > 0) // empty files can't be mapped
+		{
+			HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+			void* view = (mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL);
+			if (view == NULL)
+			{
+				if (mapping != NULL)
+				{
+					CloseHandle(mapping);
+				}
+				CloseHandle(file);
+				log(message);
+				throw TheoraplayerException(message);
+			}
+			this->mappingHandle = mapping;
+			this->data = (unsigned char*)view;
+		}
+		this->fileHandle = file;
+#elif defined(_WINRT)
+		FILE* file = fopen(this->fullFilename.c_str(), "rb");
+		if (file == NULL)
+		{
+			log(message);
+			throw TheoraplayerException(message);
+		}
+		struct _stat64 s;
+		_fstati64(_fileno(file), &s);
+		this->size = (int64_t)s.st_size;
+		if (this->size > 0)
+		{
+			this->data = new unsigned char[(size_t)this->size];
+			fread(this->data, 1, (size_t)this->size, file);
+		}
+		fclose(file);
+#else
+		int file = open(this->fullFilename.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			log(message);
+			throw TheoraplayerException(message);
+		}
+		struct stat s;
+		fstat(file, &s);
+		this->size = (int64_t)s.st_size;
+		if (this->size > 0) // empty files can't be mapped
+		{
+			void* view = mmap(NULL, (size_t)this->size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (view == MAP_FAILED)
+			{
+				close(file);
+				log(message);
+				throw TheoraplayerException(message);
+			}
+			this->data = (unsigned char*)view;
+		}
+		close(file); // the mapping stays valid after the file is closed
+#endif
+		this->mapped = true;
+	}
+
+	int64_t MappedFileDataSource::getSize()
+	{
+		this->_mapFile();
+		return this->size;
+	}
+
+	const unsigned char* MappedFileDataSource::getData()
+	{
+		this->_mapFile();
+		return this->data;
+	}
+
+	int MappedFileDataSource::read(void* output, int count)
+	{
+		this->_mapFile();
+		int result = (int)((this->position + count <= this->size) ? count : this->size - this->position);
+		if (result > 0)
+		{
+			memcpy(output, this->data + this->position, result);
+			this->position += result;
+		}
+		return (result > 0 ? result : 0);
+	}
+
+	void MappedFileDataSource::seek(int64_t byteIndex)
+	{
+		this->position = byteIndex;
+	}
+
+	DataSource* MappedFileDataSource::clone()
+	{
+		this->_mapFile();
+		// the memory data source only reads the data
+		return new MemoryDataSource(this->data, (long)this->size, this->formatName, this->filename, false);
+	}
+
+}
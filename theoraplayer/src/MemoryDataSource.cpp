@@ -114,4 +114,10 @@ namespace theoraplayer
 		this->position = byteIndex;
 	}
 
+	DataSource* MemoryDataSource::clone()
+	{
+		this->_loadFile();
+		return new MemoryDataSource(this->data, (long)this->size, this->formatName, this->filename, false);
+	}
+
 }
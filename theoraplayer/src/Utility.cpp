@@ -53,6 +53,12 @@ namespace theoraplayer
 		return value;
 	}
 
+	int getBytesPerPixel(OutputMode mode)
+	{
+		static int bytemap[] = { 0, 3, 4, 4, 4, 4, 3, 4, 4, 4, 4, 1, 3, 4, 4, 4, 4, 3, 4, 4, 4, 4, 2, 2, 2 };
+		return bytemap[mode];
+	}
+
 	FILE* openSupportedFormatFile(const std::string& filename, VideoClip::Format& outFormat, std::string& outFullFilename)
 	{
 		FILE* file = NULL;
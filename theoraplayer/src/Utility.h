@@ -38,6 +38,7 @@
 #ifdef _USE_THEORA
 #define THEORA_DECODER_NAME "Theora"
 #endif
+#define FRAME_CACHE_FORMAT_NAME "FrameCache"
 
 namespace theoraplayer
 {
@@ -47,6 +48,8 @@ namespace theoraplayer
 	std::string strf(float i);
 	bool stringEndsWith(const std::string& string, const std::string& suffix);
 	int potCeil(int value);
+	/// @return Number of bytes a pixel of the output mode takes.
+	int getBytesPerPixel(OutputMode mode);
 	FILE* openSupportedFormatFile(const std::string& filename, VideoClip::Format& outFormat, std::string& outFullFilename);
 
 }
@@ -0,0 +1,260 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <algorithm>
+#include <memory.h>
+
+#include "Exception.h"
+#include "Manager.h"
+#include "Utility.h"
+#include "VideoAtlas.h"
+#include "VideoClip.h"
+#include "VideoFrame.h"
+
+namespace theoraplayer
+{
+	VideoAtlas::VideoAtlas(int width, int height, OutputMode outputMode) : front(0), updateIndex(0), rowX(0), rowY(0), rowHeight(0)
+	{
+		if (outputMode == FORMAT_UNDEFINED)
+		{
+			throw TheoraplayerException("Invalid output mode: FORMAT_UNDEFINED for video atlas");
+		}
+		this->width = width;
+		this->height = height;
+		this->outputMode = outputMode;
+		this->bpp = getBytesPerPixel(outputMode);
+		this->pitch = width * this->bpp;
+		for (int i = 0; i < 2; ++i)
+		{
+			this->surfaces[i] = new unsigned char[this->pitch * height];
+			memset(this->surfaces[i], 0, this->pitch * height);
+		}
+	}
+
+	VideoAtlas::~VideoAtlas()
+	{
+		delete[] this->surfaces[0];
+		delete[] this->surfaces[1];
+	}
+
+	bool VideoAtlas::addClip(VideoClip* clip)
+	{
+		if (clip->getOutputMode() != this->outputMode)
+		{
+			throw TheoraplayerException("Output mode of video " + clip->getName() + " doesn't match the video atlas");
+		}
+		if (this->slots.find(clip) != this->slots.end())
+		{
+			return true;
+		}
+		Slot slot;
+		slot.region.width = clip->getWidth();
+		slot.region.height = clip->getHeight();
+		slot.updateIndex = 0;
+		// the region of a removed clip is reused if the clip fits into it
+		bool found = false;
+		foreach (Region, it, this->freeRegions)
+		{
+			if (it->width >= slot.region.width && it->height >= slot.region.height)
+			{
+				Region region = (*it);
+				this->freeRegions.erase(it);
+				slot.region.x = region.x;
+				slot.region.y = region.y;
+				// the rest of the region stays free
+				Region rest;
+				rest.x = region.x + slot.region.width;
+				rest.y = region.y;
+				rest.width = region.width - slot.region.width;
+				rest.height = slot.region.height;
+				if (rest.width > 0)
+				{
+					this->_addFreeRegion(rest);
+				}
+				rest.x = region.x;
+				rest.y = region.y + slot.region.height;
+				rest.width = region.width;
+				rest.height = region.height - slot.region.height;
+				if (rest.height > 0)
+				{
+					this->_addFreeRegion(rest);
+				}
+				found = true;
+				break;
+			}
+		}
+		if (!found)
+		{
+			if (this->rowX + slot.region.width > this->width)
+			{
+				this->rowX = 0;
+				this->rowY += this->rowHeight;
+				this->rowHeight = 0;
+			}
+			if (this->rowX + slot.region.width > this->width || this->rowY + slot.region.height > this->height)
+			{
+				return false;
+			}
+			slot.region.x = this->rowX;
+			slot.region.y = this->rowY;
+			this->rowX += slot.region.width;
+			this->rowHeight = std::max(this->rowHeight, slot.region.height);
+		}
+		this->slots[clip] = slot;
+		return true;
+	}
+
+	void VideoAtlas::removeClip(VideoClip* clip)
+	{
+		std::map<VideoClip*, Slot>::iterator it = this->slots.find(clip);
+		if (it == this->slots.end())
+		{
+			return;
+		}
+		// the region is cleared in both surfaces before it's assigned again, so no picture of the removed clip can show up later
+		this->clearRegions.push_back(it->second.region);
+		this->_addFreeRegion(it->second.region);
+		this->slots.erase(it);
+		foreach (VideoClip*, it2, this->staleClips)
+		{
+			if ((*it2) == clip)
+			{
+				this->staleClips.erase(it2);
+				break;
+			}
+		}
+	}
+
+	VideoAtlas::Region VideoAtlas::getRegion(VideoClip* clip) const
+	{
+		std::map<VideoClip*, Slot>::const_iterator it = this->slots.find(clip);
+		if (it != this->slots.end())
+		{
+			return it->second.region;
+		}
+		Region region;
+		region.x = region.y = region.width = region.height = 0;
+		return region;
+	}
+
+	void VideoAtlas::update()
+	{
+		this->dirtyRegions.clear();
+		unsigned char* shown = this->surfaces[this->front];
+		unsigned char* back = this->surfaces[1 - this->front];
+		// cleared regions are written before the clips' pictures, a clip may have been assigned a part of one since
+		foreach (Region, it, this->staleClearRegions)
+		{
+			this->_clearRegion(back, (*it));
+		}
+		this->staleClearRegions.clear();
+		foreach (Region, it, this->clearRegions)
+		{
+			this->_clearRegion(back, (*it));
+			this->dirtyRegions.push_back(*it);
+		}
+		// the surface that's shown now still has to be cleared by the next update
+		this->staleClearRegions.swap(this->clearRegions);
+		++this->updateIndex;
+		std::vector<VideoClip*> previousStaleClips;
+		previousStaleClips.swap(this->staleClips);
+		// only clips that Manager::update() found a due frame for are read
+		const std::vector<VideoClip*>& dueClips = theoraplayer::manager->getClipsWithDueFrames();
+		std::map<VideoClip*, Slot>::iterator slot;
+		VideoFrame* frame = NULL;
+		foreachc (VideoClip*, it, dueClips)
+		{
+			slot = this->slots.find(*it);
+			if (slot == this->slots.end())
+			{
+				continue;
+			}
+			frame = (*it)->fetchNextFrame();
+			if (frame != NULL)
+			{
+				if ((*it)->getOutputMode() == this->outputMode)
+				{
+					this->_copyPicture(frame->getBuffer(), frame->getPitch(), frame->getWidth(), frame->getHeight(), back, slot->second.region);
+					this->dirtyRegions.push_back(slot->second.region);
+					slot->second.updateIndex = this->updateIndex;
+					// the shown surface becomes the back surface and has the older picture now
+					this->staleClips.push_back(*it);
+				}
+				(*it)->popFrame();
+			}
+		}
+		// the back surface still has the picture from before the last update, only regions that changed then are caught up
+		foreach (VideoClip*, it, previousStaleClips)
+		{
+			slot = this->slots.find(*it);
+			if (slot != this->slots.end() && slot->second.updateIndex != this->updateIndex)
+			{
+				const Region& region = slot->second.region;
+				this->_copyPicture(shown + region.y * this->pitch + region.x * this->bpp, this->pitch, region.width, region.height, back, region);
+			}
+		}
+		this->front = 1 - this->front;
+	}
+
+	void VideoAtlas::_copyPicture(const unsigned char* source, int sourcePitch, int sourceWidth, int sourceHeight, unsigned char* surface,
+		const Region& region)
+	{
+		unsigned char* destination = surface + region.y * this->pitch + region.x * this->bpp;
+		int size = std::min(sourceWidth, region.width) * this->bpp;
+		int height = std::min(sourceHeight, region.height);
+		for (int i = 0; i < height; ++i)
+		{
+			memcpy(destination, source, size);
+			destination += this->pitch;
+			source += sourcePitch;
+		}
+	}
+
+	void VideoAtlas::_clearRegion(unsigned char* surface, const Region& region)
+	{
+		unsigned char* destination = surface + region.y * this->pitch + region.x * this->bpp;
+		int size = region.width * this->bpp;
+		for (int i = 0; i < region.height; ++i)
+		{
+			memset(destination, 0, size);
+			destination += this->pitch;
+		}
+	}
+
+	void VideoAtlas::_addFreeRegion(Region region)
+	{
+		// a merged region can share an edge with another free region, so merging goes on until nothing changes
+		bool merged = true;
+		while (merged)
+		{
+			merged = false;
+			foreach (Region, it, this->freeRegions)
+			{
+				if (it->y == region.y && it->height == region.height && (it->x + it->width == region.x || region.x + region.width == it->x))
+				{
+					region.x = std::min(region.x, it->x);
+					region.width += it->width;
+				}
+				else if (it->x == region.x && it->width == region.width && (it->y + it->height == region.y || region.y + region.height == it->y))
+				{
+					region.y = std::min(region.y, it->y);
+					region.height += it->height;
+				}
+				else
+				{
+					continue;
+				}
+				this->freeRegions.erase(it);
+				merged = true;
+				break;
+			}
+		}
+		this->freeRegions.push_back(region);
+	}
+
+}
@@ -6,29 +6,47 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <algorithm>
 #include <math.h>
+#include <memory.h>
 
 #include "Manager.h"
 #include "AudioInterface.h"
 
 #include "DataSource.h"
 #include "Exception.h"
+#include "FrameCache/FrameCacheWriter.h"
 #include "FrameQueue.h"
 #include "Mutex.h"
+#include "theoraplayer.h"
 #include "Thread.h"
 #include "Timer.h"
 #include "Utility.h"
 #include "VideoClip.h"
+#include "VideoClipView.h"
 #include "VideoFrame.h"
 
+#define DEFAULT_CHECKPOINT_MEMORY_LIMIT (64 * 1024 * 1024)
+#define DEFAULT_SCRUB_REFINE_DELAY 0.2f
+#define DEFAULT_REVERSE_FRAMES_BUDGET 16
+
 namespace theoraplayer
 {
 	VideoClip::VideoClip(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride) :
-		frameQueue(NULL), audioInterface(NULL), stream(NULL), timer(NULL), assignedWorkerThread(NULL), audioMutex(NULL),
+		frameQueue(NULL), frameOffset(0), audioInterface(NULL), stream(NULL), timer(NULL), assignedWorkerThread(NULL), prerolling(false), audioMutex(NULL),
 		threadAccessMutex(NULL), threadAccessCount(0), useAlpha(false), useStride(false), precachedFramesCount(4), audioGain(1.0f),
-		autoRestart(false), outputMode(FORMAT_UNDEFINED), priority(1.0f), duration(-1.0f), frameDuration(0.0f), width(0), height(0),
-		stride(0), framesCount(-1), fps(1), endOfFile(false), waitingForCache(false), subFrameX(0), subFrameY(0), subFrameWidth(0),
-		subFrameHeight(0), seekFrame(-1), requestedOutputMode(FORMAT_UNDEFINED), firstFrameDisplayed(false), restarted(false), iteration(0),
+		autoRestart(false), outputMode(FORMAT_UNDEFINED), dithering(false), premultipliedAlpha(false), outputScale(1.0f),
+		scaleFilter(SCALE_FILTER_BOX), outputCropping(false), priority(1.0f), visibility(VISIBILITY_VISIBLE), postProcessingLevel(0), maxPostProcessingLevel(0),
+		autoPostProcessing(false), postProcessingDroppedFramesCount(0), postProcessingTime(0.0f), prerollFramesCount(0), loopCacheMemoryLimit(0),
+		loopCacheFramesCount(0), loopCacheFrameSize(0), loopCacheOutputMode(FORMAT_UNDEFINED), loopCacheIndex(-1), frameCacheWriter(NULL), incrementalConversion(false), outputBuffersPitch(0),
+		outputBufferReleaseCallback(NULL), outputBufferUserData(NULL), frameCallback(NULL), frameCallbackUserData(NULL), nextFrameTimeKnown(false),
+		nextFrameReady(false), nextFrameTime(0.0f), checkpointInterval(0),
+		checkpointMemoryLimit(DEFAULT_CHECKPOINT_MEMORY_LIMIT), keyFrameSpeedThreshold(0.0f), reverseFramesBudget(DEFAULT_REVERSE_FRAMES_BUDGET),
+		trickPlayKeyFrames(false), trickPlayReverse(false), requestedTrickPlayKeyFrames(false), requestedTrickPlayReverse(false), duration(-1.0f), frameDuration(0.0f),
+		width(0), height(0), stride(0), framesCount(-1), fps(1), endOfFile(false), waitingForCache(false), subFrameX(0), subFrameY(0), subFrameWidth(0),
+		subFrameHeight(0), seekFrame(-1), scrubFrame(-1), scrubTargetFrame(-1),
+		scrubRefineDelay(DEFAULT_SCRUB_REFINE_DELAY), scrubTime(0.0f), requestedOutputMode(FORMAT_UNDEFINED), loaded(false), loadFailed(false), retiring(false),
+		firstFrameDisplayed(false), restarted(false), iteration(0),
 		playbackIteration(0), droppedFramesCount(0), displayedFramesCount(0)
 	{
 		this->name = dataSource->toString();
@@ -49,6 +67,10 @@ namespace theoraplayer
 		{
 			delete this->stream;
 		}
+		foreach (VideoClipView*, it, this->views)
+		{
+			delete (*it);
+		}
 		if (this->frameQueue != NULL)
 		{
 			delete this->frameQueue;
@@ -60,6 +82,11 @@ namespace theoraplayer
 			audioMutexLock.release();
 			delete this->audioMutex;
 		}
+		this->_clearLoopCache();
+		if (this->frameCacheWriter != NULL)
+		{
+			delete this->frameCacheWriter;
+		}
 		lock.release();
 		delete this->threadAccessMutex;
 	}
@@ -137,6 +164,24 @@ namespace theoraplayer
 	void VideoClip::setPlaybackSpeed(float speed)
 	{
 		this->timer->setSpeed(speed);
+		if (this->scrubTargetFrame < 0)
+		{
+			this->_updateTrickPlayMode();
+		}
+	}
+
+	void VideoClip::setKeyFrameSpeedThreshold(float value)
+	{
+		this->keyFrameSpeedThreshold = (value > 0.0f ? value : 0.0f);
+		if (this->scrubTargetFrame < 0)
+		{
+			this->_updateTrickPlayMode();
+		}
+	}
+
+	void VideoClip::setReverseFramesBudget(int value)
+	{
+		this->reverseFramesBudget = (value > 1 ? value : 1);
 	}
 
 	void VideoClip::setOutputMode(OutputMode value)
@@ -151,16 +196,70 @@ namespace theoraplayer
 		}
 		this->requestedOutputMode = value;
 		this->useAlpha = (value == FORMAT_RGBA || value == FORMAT_ARGB || value == FORMAT_BGRA || value == FORMAT_ABGR ||
-			value == FORMAT_GREY3A || value == FORMAT_AGREY3 || value == FORMAT_YUVA || value == FORMAT_AYUV);
-		if (this->assignedWorkerThread != NULL)
+			value == FORMAT_GREY3A || value == FORMAT_AGREY3 || value == FORMAT_YUVA || value == FORMAT_AYUV || value == FORMAT_RGBA4444 ||
+			value == FORMAT_RGBA5551);
+		// frames have to be recreated even while no worker thread is decoding the clip, they were allocated for the old pixel size
+		if (this->frameQueue != NULL)
 		{
 			Mutex::ScopeLock lock(this->threadAccessMutex);
+			// the cropped size depends on the alpha channel
+			this->_updateOutputSize();
 			// discard current frames and recreate them
 			this->frameQueue->setSize(this->frameQueue->getSize());
+			this->_resetFrameOffsets();
 		}
 		this->outputMode = this->requestedOutputMode;
 	}
 
+	void VideoClip::setDithering(bool value)
+	{
+		this->dithering = value;
+	}
+
+	void VideoClip::setPremultipliedAlpha(bool value)
+	{
+		this->premultipliedAlpha = value;
+	}
+
+	void VideoClip::setOutputScale(float value, ScaleFilter filter)
+	{
+		if (value <= 0.0f || value > 1.0f)
+		{
+			value = 1.0f;
+		}
+		this->scaleFilter = filter;
+		if (this->outputScale == value)
+		{
+			return;
+		}
+		Mutex::ScopeLock lock(this->threadAccessMutex);
+		this->outputScale = value;
+		this->_resizeFrames();
+	}
+
+	void VideoClip::setOutputCropping(bool value)
+	{
+		if (this->outputCropping == value)
+		{
+			return;
+		}
+		Mutex::ScopeLock lock(this->threadAccessMutex);
+		this->outputCropping = value;
+		this->_resizeFrames();
+	}
+
+	void VideoClip::_resizeFrames()
+	{
+		if (this->frameQueue != NULL)
+		{
+			this->_updateOutputSize();
+			// discard current frames and recreate them
+			this->frameQueue->setSize(this->frameQueue->getSize());
+			this->_resetFrameOffsets();
+			this->_clearLoopCache();
+		}
+	}
+
 	void VideoClip::setAutoRestart(bool value)
 	{
 		this->autoRestart = value;
@@ -170,6 +269,75 @@ namespace theoraplayer
 		}
 	}
 
+	void VideoClip::setPostProcessingLevel(int value)
+	{
+		if (value > this->maxPostProcessingLevel)
+		{
+			value = this->maxPostProcessingLevel;
+		}
+		if (value < 0)
+		{
+			value = 0;
+		}
+		this->autoPostProcessing = false;
+		this->postProcessingLevel = value;
+	}
+
+	void VideoClip::setAutoPostProcessing(bool value)
+	{
+		this->autoPostProcessing = value;
+		this->postProcessingDroppedFramesCount = this->droppedFramesCount;
+		this->postProcessingTime = 0.0f;
+	}
+
+	void VideoClip::setPrerollFramesCount(int value)
+	{
+		this->prerollFramesCount = (value > 0 ? value : 0);
+	}
+
+	void VideoClip::setLoopCacheMemoryLimit(int64_t value)
+	{
+		Mutex::ScopeLock lock(this->threadAccessMutex);
+		this->loopCacheMemoryLimit = (value > 0 ? value : 0);
+		this->_clearLoopCache();
+	}
+
+	void VideoClip::setIncrementalConversion(bool value)
+	{
+		this->incrementalConversion = value;
+	}
+
+	void VideoClip::setOutputBuffers(const std::vector<unsigned char*>& buffers, int pitch, void (*releaseCallback)(VideoClip* clip, unsigned char* buffer, void* userData),
+		void* userData)
+	{
+		Mutex::ScopeLock lock(this->frameQueue != NULL ? this->frameQueue->getMutex() : NULL);
+		this->outputBuffers = buffers;
+		this->freeOutputBuffers = buffers;
+		this->outputBuffersPitch = (buffers.size() > 0 ? pitch : 0);
+		this->outputBufferReleaseCallback = releaseCallback;
+		this->outputBufferUserData = userData;
+	}
+
+	void VideoClip::setCheckpointInterval(int value)
+	{
+		this->checkpointInterval = (value > 0 ? value : 0);
+	}
+
+	void VideoClip::setCheckpointMemoryLimit(int64_t value)
+	{
+		this->checkpointMemoryLimit = (value > 0 ? value : 0);
+	}
+
+	void VideoClip::setScrubRefineDelay(float value)
+	{
+		this->scrubRefineDelay = (value > 0.0f ? value : 0.0f);
+	}
+
+	bool VideoClip::isLoopCached() const
+	{
+		return (this->framesCount > 0 && this->loopCacheFramesCount == this->framesCount);
+	}
+
 	float VideoClip::getPriorityIndex() const
 	{
 		float priority = (float)this->getReadyFramesCount();
@@ -180,6 +348,21 @@ namespace theoraplayer
 		return priority;
 	}
 
+	void VideoClip::setVisibility(Visibility value)
+	{
+		if (this->visibility == value)
+		{
+			return;
+		}
+		Visibility previous = this->visibility;
+		this->visibility = value;
+		// the decoder stopped where the clip became dormant, so it starts over at the current frame
+		if (previous == VISIBILITY_DORMANT && this->loaded && this->seekFrame < 0)
+		{
+			this->seekToFrame((int)(this->timer->getTime() * this->fps));
+		}
+	}
+
 	int VideoClip::getPrecachedFramesCount() const
 	{
 		return this->frameQueue->getSize();
@@ -190,16 +373,23 @@ namespace theoraplayer
 		if (this->frameQueue->getSize() != count)
 		{
 			this->frameQueue->setSize(count);
+			this->_resetFrameOffsets();
 		}
 	}
 
 	int VideoClip::getReadyFramesCount() const
 	{
-		if (this->seekFrame != -1)
+		return this->_getReadyFramesCount(this->frameOffset);
+	}
+
+	int VideoClip::_getReadyFramesCount(int frameOffset) const
+	{
+		if (!this->loaded || this->seekFrame != -1 || this->scrubFrame != -1)
 		{
 			return 0; // clip is about to seek, consider frame queue empty (even though it will be actually emptied upon seek)
 		}
-		return this->frameQueue->getReadyCount();
+		// frames already popped by this reader stay in the queue for the other readers
+		return std::max(this->frameQueue->getReadyCount() - frameOffset, 0);
 	}
 
 	bool VideoClip::isDone() const
@@ -222,7 +412,7 @@ namespace theoraplayer
 
 	bool VideoClip::_isBusy() const
 	{
-		return (this->assignedWorkerThread != NULL || this->outputMode != this->requestedOutputMode);
+		return (!this->loaded || this->assignedWorkerThread != NULL || this->outputMode != this->requestedOutputMode);
 	}
 
 	float VideoClip::_getAbsPlaybackTime() const
@@ -232,7 +422,9 @@ namespace theoraplayer
 
 	float VideoClip::updateTimerToNextFrame()
 	{
-		VideoFrame* frame = this->frameQueue->getFirstAvailableFrame();
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		VideoFrame* frame = this->frameQueue->_getAvailableFrame(this->frameOffset);
+		lock.release();
 		if (frame == NULL)
 		{
 			return 0.0f;
@@ -247,20 +439,36 @@ namespace theoraplayer
 	}
 
 	VideoFrame* VideoClip::fetchNextFrame()
+	{
+		return this->_fetchNextFrame(this->frameOffset, this->firstFrameDisplayed, this->droppedFramesCount);
+	}
+
+	VideoFrame* VideoClip::_fetchNextFrame(int& frameOffset, bool firstFrameDisplayed, int& droppedFramesCount)
 	{
 		// if we are about to seek, then the current frame queue is invalidated
 		// (will be cleared when a worker thread does the actual seek)
-		if (this->seekFrame != -1)
+		if (!this->loaded || this->seekFrame != -1 || this->scrubFrame != -1)
 		{
 			return NULL;
 		}
 		Mutex::ScopeLock lock(this->frameQueue->getMutex());
 		float time = this->_getAbsPlaybackTime();
-		this->_discardOutdatedFrames(time);
-		VideoFrame* frame = this->frameQueue->_getFirstAvailableFrame();
-		if (frame != NULL && frame->timeToDisplay + frame->iteration * this->duration > time && this->firstFrameDisplayed)
+		droppedFramesCount += this->_discardOutdatedFrames(time, frameOffset);
+		VideoFrame* frame = this->frameQueue->_getAvailableFrame(frameOffset);
+		// frames decoded while the clip was hidden have no picture
+		while (frame != NULL && frame->timestampOnly)
 		{
-			frame = NULL; // frame is ready but it's not yet time to display it, except when we haven't displayed any frames yet
+			this->_popFrames(frameOffset, 1);
+			frame = this->frameQueue->_getAvailableFrame(frameOffset);
+		}
+		if (frame != NULL && firstFrameDisplayed)
+		{
+			float timeToDisplay = frame->timeToDisplay + frame->iteration * this->duration;
+			// when playing backwards, a frame is due once the time drops below its end
+			if (this->trickPlayReverse ? timeToDisplay + this->frameDuration <= time : timeToDisplay > time)
+			{
+				frame = NULL; // frame is ready but it's not yet time to display it, except when we haven't displayed any frames yet
+			}
 		}
 		return frame;
 	}
@@ -270,15 +478,129 @@ namespace theoraplayer
 		++this->displayedFramesCount;
 		// after transfering frame data to the texture, free the frame
 		// so it can be used again
-		if (!this->firstFrameDisplayed)
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		this->_popFrames(this->frameOffset, 1);
+		this->firstFrameDisplayed = true;
+		this->nextFrameTimeKnown = false;
+	}
+
+	void VideoClip::acquireFrame(VideoFrame* frame)
+	{
+		this->frameQueue->acquire(frame);
+	}
+
+	void VideoClip::releaseFrame(VideoFrame* frame)
+	{
+		this->frameQueue->release(frame);
+	}
+
+	void VideoClip::setFrameCallback(void (*callback)(VideoClip* clip, VideoFrame* frame, float timeToDisplay, void* userData), void* userData)
+	{
+		this->frameCallback = callback;
+		this->frameCallbackUserData = userData;
+	}
+
+	VideoClipView* VideoClip::createView()
+	{
+		VideoClipView* view = new VideoClipView(this);
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		// the view starts at the clip's current frame
+		view->frameOffset = this->frameOffset;
+		this->views.push_back(view);
+		return view;
+	}
+
+	void VideoClip::destroyView(VideoClipView* view)
+	{
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		foreach (VideoClipView*, it, this->views)
+		{
+			if ((*it) == view)
+			{
+				this->views.erase(it);
+				break;
+			}
+		}
+		this->_popFrames(this->frameOffset, 0); // the frames only this view was holding back can be reused now
+		lock.release();
+		delete view;
+	}
+
+	void VideoClip::_popFrames(int& frameOffset, int count)
+	{
+		frameOffset += count;
+		int releasedCount = this->frameOffset;
+		foreach (VideoClipView*, it, this->views)
+		{
+			releasedCount = std::min(releasedCount, (*it)->frameOffset);
+		}
+		if (releasedCount > 0)
+		{
+			this->frameQueue->_pop(releasedCount);
+			this->frameOffset -= releasedCount;
+			foreach (VideoClipView*, it, this->views)
+			{
+				(*it)->frameOffset -= releasedCount;
+			}
+		}
+	}
+
+	void VideoClip::_resetFrameOffsets()
+	{
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		this->frameOffset = 0;
+		foreach (VideoClipView*, it, this->views)
+		{
+			(*it)->frameOffset = 0;
+		}
+		this->nextFrameTimeKnown = false;
+	}
+
+	void VideoClip::_discardHiddenFrames()
+	{
+		Mutex::ScopeLock lock(this->frameQueue->getMutex());
+		float time = this->_getAbsPlaybackTime();
+		this->_discardOutdatedFrames(time, this->frameOffset);
+		foreach (VideoClipView*, it, this->views)
+		{
+			this->_discardOutdatedFrames(time, (*it)->frameOffset);
+		}
+		this->nextFrameTimeKnown = false;
+	}
+
+	bool VideoClip::_isFrameDue()
+	{
+		if (!this->nextFrameTimeKnown)
 		{
 			Mutex::ScopeLock lock(this->frameQueue->getMutex());
-			this->frameQueue->_pop(1);
-			this->firstFrameDisplayed = true;
+			VideoFrame* frame = this->frameQueue->_getAvailableFrame(this->frameOffset);
+			this->nextFrameReady = (frame != NULL);
+			if (frame != NULL)
+			{
+				this->nextFrameTime = frame->timeToDisplay + frame->iteration * this->duration;
+			}
+			this->nextFrameTimeKnown = true;
 		}
-		else
+		if (!this->nextFrameReady || this->seekFrame != -1 || this->scrubFrame != -1)
 		{
-			this->frameQueue->pop();
+			return false;
+		}
+		if (!this->firstFrameDisplayed)
+		{
+			return true;
+		}
+		float time = this->_getAbsPlaybackTime();
+		// same as in _fetchNextFrame(), when playing backwards a frame is due once the time drops below its end
+		return (this->trickPlayReverse ? this->nextFrameTime + this->frameDuration > time : this->nextFrameTime <= time);
+	}
+
+	void VideoClip::_deliverFrame()
+	{
+		VideoFrame* frame = this->fetchNextFrame();
+		if (frame != NULL && this->frameCallback != NULL)
+		{
+			(*this->frameCallback)(this, frame, frame->getTimeToDisplay(), this->frameCallbackUserData);
+			this->popFrame();
 		}
 	}
 
@@ -311,6 +633,8 @@ namespace theoraplayer
 		this->endOfFile = false;
 		this->restarted = false;
 		this->seekFrame = -1;
+		this->scrubFrame = -1;
+		this->scrubTargetFrame = -1;
 	}
 
 	void VideoClip::seek(float time)
@@ -332,6 +656,36 @@ namespace theoraplayer
 		{
 			this->seekFrame = frame;
 		}
+		this->scrubFrame = -1;
+		this->scrubTargetFrame = -1;
+		this->firstFrameDisplayed = false;
+		this->endOfFile = false;
+	}
+
+	void VideoClip::scrub(float time)
+	{
+		this->scrubToFrame((int)(time * this->getFps()));
+	}
+
+	void VideoClip::scrubToFrame(int frame)
+	{
+		if (this->framesCount > 0)
+		{
+			frame = std::min(frame, this->framesCount - 1);
+		}
+		frame = std::max(frame, 0);
+		if (frame == this->scrubTargetFrame)
+		{
+			return;
+		}
+		// previews are decoded forward, the trick-play mode is requested again once the target is refined
+		this->requestedTrickPlayKeyFrames = false;
+		this->requestedTrickPlayReverse = false;
+		// a pending request that no worker thread has picked up yet is simply replaced
+		this->scrubFrame = frame;
+		this->scrubTargetFrame = frame;
+		this->scrubTime = 0.0f;
+		this->seekFrame = -1;
 		this->firstFrameDisplayed = false;
 		this->endOfFile = false;
 	}
@@ -372,15 +726,43 @@ namespace theoraplayer
 
 	void VideoClip::update(float timeDelta)
 	{
+		if (this->scrubTargetFrame >= 0)
+		{
+			this->scrubTime += timeDelta;
+			if (this->scrubTime >= this->scrubRefineDelay)
+			{
+				this->seekToFrame(this->scrubTargetFrame);
+			}
+		}
+		if (this->scrubTargetFrame < 0)
+		{
+			this->_updateTrickPlayMode();
+		}
 		if (this->timer->isPaused())
 		{
 			this->timer->update(0); // update timer in case there is some code that needs to execute each frame
 			return;
 		}
 		float time = this->timer->getTime(), speed = this->timer->getSpeed();
-		if (time + timeDelta * speed >= this->duration)
+		if (speed < 0.0f)
 		{
-			if (this->autoRestart && this->restarted)
+			// playing backwards stops at the first frame
+			if (time + timeDelta * speed <= 0.0f)
+			{
+				if (time != 0.0f)
+				{
+					this->timer->update(time / -speed);
+				}
+			}
+			else
+			{
+				this->timer->update(timeDelta);
+			}
+		}
+		else if (time + timeDelta * speed >= this->duration)
+		{
+			// dormant clips don't decode, so their time loops without waiting for the decoder to restart
+			if (this->autoRestart && (this->restarted || this->visibility == VISIBILITY_DORMANT))
 			{
 				float seekTime = time + timeDelta * speed;
 				while (seekTime >= this->duration)
@@ -399,18 +781,68 @@ namespace theoraplayer
 		{
 			this->timer->update(timeDelta);
 		}
+		if (this->visibility == VISIBILITY_TIMESTAMPS_ONLY)
+		{
+			this->_discardHiddenFrames();
+		}
+	}
+
+	void VideoClip::_updateTrickPlayMode()
+	{
+		float speed = this->timer->getSpeed();
+		bool reverse = (speed < 0.0f);
+		bool keyFrames = (this->keyFrameSpeedThreshold > 0.0f && fabs(speed) >= this->keyFrameSpeedThreshold);
+		if (reverse == this->requestedTrickPlayReverse && keyFrames == this->requestedTrickPlayKeyFrames)
+		{
+			return;
+		}
+		this->requestedTrickPlayReverse = reverse;
+		this->requestedTrickPlayKeyFrames = keyFrames;
+		// a pending seek switches the mode on its own, otherwise the decoder starts over at the current frame in the new mode
+		if (this->seekFrame < 0)
+		{
+			this->seekToFrame((int)(this->timer->getTime() * this->fps));
+		}
+	}
+
+	void VideoClip::_applyTrickPlayMode()
+	{
+		this->trickPlayKeyFrames = this->requestedTrickPlayKeyFrames;
+		this->trickPlayReverse = this->requestedTrickPlayReverse;
+	}
+
+	void VideoClip::_updateOutputSize()
+	{
+	}
+
+	void VideoClip::_executeScrub()
+	{
+		this->seekFrame = this->scrubFrame;
+		this->scrubFrame = -1;
+		this->_executeSeek();
+		this->_decodeNextFrame();
+	}
+
+	bool VideoClip::_isPrerollPending() const
+	{
+		return false;
+	}
+
+	void VideoClip::_prerollNextFrame()
+	{
 	}
 
 	void VideoClip::_resetFrameQueue()
 	{
 		this->frameQueue->clear();
+		this->_resetFrameOffsets();
 		this->playbackIteration = 0;
 		this->iteration = 0;
 	}
 
-	int VideoClip::_discardOutdatedFrames(float absTime)
+	int VideoClip::_discardOutdatedFrames(float absTime, int& frameOffset)
 	{
-		int readyCount = this->frameQueue->_getReadyCount();
+		int readyCount = this->frameQueue->_getReadyCount() - frameOffset;
 		// only drop frames if you have more frames to show. otherwise even the late frame will do..
 		if (readyCount == 1)
 		{
@@ -421,15 +853,20 @@ namespace theoraplayer
 		VideoFrame* frame = NULL;
 		float timeToDisplay = 0.0f;
 		std::list<VideoFrame*>& queue = this->frameQueue->_getFrameQueue();
+		int index = 0;
 		foreach_l(VideoFrame*, it, queue)
 		{
+			if (index++ < frameOffset)
+			{
+				continue; // already popped by this reader
+			}
 			frame = *it;
 			if (!frame->ready)
 			{
 				break;
 			}
 			timeToDisplay = frame->timeToDisplay + frame->iteration * this->duration;
-			if (time <= timeToDisplay + this->frameDuration)
+			if (this->trickPlayReverse ? time >= timeToDisplay : time <= timeToDisplay + this->frameDuration)
 			{
 				break;
 			}
@@ -444,8 +881,13 @@ namespace theoraplayer
 #ifdef _DEBUG_FRAMEDROP
 			std::string message = this->getName() + ": dropped frame ";
 			int i = popCount;
+			index = 0;
 			foreach_l (VideoFrame*, it, queue)
 			{
+				if (index++ < frameOffset)
+				{
+					continue;
+				}
 				message += str((int)(*it)->getFrameNumber());
 				if (i <= 1)
 				{
@@ -456,8 +898,7 @@ namespace theoraplayer
 			}
 			log(message);
 #endif
-			this->droppedFramesCount += popCount;
-			this->frameQueue->_pop(popCount);
+			this->_popFrames(frameOffset, popCount);
 		}
 		return popCount;
 	}
@@ -497,4 +938,190 @@ namespace theoraplayer
 		frame->frameNumber = value;
 	}
 
+	void VideoClip::_setVideoFrameTimestampOnly(VideoFrame* frame, bool value)
+	{
+		frame->timestampOnly = value;
+	}
+
+	void VideoClip::_setVideoFrameDirtyMacroblocks(VideoFrame* frame, const unsigned char* macroblocks)
+	{
+		frame->hasDirtyMacroblocks = (macroblocks != NULL);
+		if (macroblocks != NULL)
+		{
+			int size = frame->getMacroblocksCountX() * frame->getMacroblocksCountY();
+			if (frame->dirtyMacroblocks == NULL)
+			{
+				frame->dirtyMacroblocks = new unsigned char[size];
+			}
+			memcpy(frame->dirtyMacroblocks, macroblocks, size);
+		}
+	}
+
+	int VideoClip::_getVideoFramePictureSerial(VideoFrame* frame) const
+	{
+		return frame->pictureSerial;
+	}
+
+	void VideoClip::_setVideoFramePictureSerial(VideoFrame* frame, int value)
+	{
+		frame->pictureSerial = value;
+	}
+
+	void VideoClip::_storeDecodedFrame(VideoFrame* frame)
+	{
+		this->_storeLoopCacheFrame(frame);
+		if (this->frameCacheWriter != NULL)
+		{
+			if (!this->frameCacheWriter->write(this, frame, this->stride * this->height * frame->bpp))
+			{
+				log(this->name + ": frame cache can't be written, discarding it");
+				delete this->frameCacheWriter;
+				this->frameCacheWriter = NULL;
+			}
+			else if (this->frameCacheWriter->isFinished())
+			{
+				delete this->frameCacheWriter;
+				this->frameCacheWriter = NULL;
+			}
+		}
+	}
+
+	void VideoClip::_storeLoopCacheFrame(VideoFrame* frame)
+	{
+		if (this->loopCacheMemoryLimit == 0 || !this->autoRestart || this->audioInterface != NULL || this->framesCount <= 0 || frame->frameNumber >= (unsigned long)this->framesCount)
+		{
+			return;
+		}
+		int frameSize = this->stride * this->height * frame->bpp;
+		if (this->loopCacheOutputMode != this->outputMode || this->loopCacheFrameSize != frameSize)
+		{
+			this->_clearLoopCache();
+		}
+		if (this->loopCacheBuffers.size() == 0)
+		{
+			if ((int64_t)frameSize * this->framesCount > this->loopCacheMemoryLimit)
+			{
+				return; // doesn't fit
+			}
+			this->loopCacheBuffers.resize(this->framesCount, NULL);
+			this->loopCacheTimes.resize(this->framesCount, 0.0f);
+			this->loopCacheFrameSize = frameSize;
+			this->loopCacheOutputMode = this->outputMode;
+		}
+		if (this->loopCacheBuffers[frame->frameNumber] == NULL)
+		{
+			unsigned char* buffer = new unsigned char[frameSize];
+			frame->_copyPictureTo(buffer, frameSize / this->height);
+			this->loopCacheBuffers[frame->frameNumber] = buffer;
+			this->loopCacheTimes[frame->frameNumber] = frame->timeToDisplay;
+			++this->loopCacheFramesCount;
+		}
+	}
+
+	bool VideoClip::_startLoopCachePlayback()
+	{
+		if (!this->isLoopCached() || this->loopCacheOutputMode != this->outputMode)
+		{
+			return false;
+		}
+		this->loopCacheIndex = this->framesCount; // the first fetch starts the next iteration
+		this->endOfFile = false;
+		this->restarted = true;
+		return true;
+	}
+
+	bool VideoClip::_fetchLoopCachedFrame(VideoFrame* frame)
+	{
+		if (this->loopCacheIndex < 0)
+		{
+			return false;
+		}
+		if (this->loopCacheOutputMode != this->outputMode || this->loopCacheFrameSize != this->stride * this->height * frame->bpp)
+		{
+			this->_clearLoopCache(); // the decoder is still at the end of the stream and will restart the regular way
+			return false;
+		}
+		if (this->loopCacheIndex >= this->framesCount)
+		{
+			if (!this->autoRestart)
+			{
+				this->loopCacheIndex = -1; // let the decoder finish the clip
+				return false;
+			}
+			this->loopCacheIndex = 0;
+			++this->iteration;
+		}
+		frame->_copyPictureFrom(this->loopCacheBuffers[this->loopCacheIndex], this->loopCacheFrameSize / this->height);
+		frame->pictureSerial = -1;
+		frame->timeToDisplay = this->loopCacheTimes[this->loopCacheIndex];
+		frame->iteration = this->iteration;
+		frame->frameNumber = this->loopCacheIndex;
+		frame->ready = true;
+		++this->loopCacheIndex;
+		return true;
+	}
+
+	void VideoClip::_stopLoopCachePlayback()
+	{
+		this->loopCacheIndex = -1;
+	}
+
+	void VideoClip::_clearLoopCache()
+	{
+		foreach (unsigned char*, it, this->loopCacheBuffers)
+		{
+			if ((*it) != NULL)
+			{
+				delete[] (*it);
+			}
+		}
+		this->loopCacheBuffers.clear();
+		this->loopCacheTimes.clear();
+		this->loopCacheFramesCount = 0;
+		this->loopCacheFrameSize = 0;
+		this->loopCacheIndex = -1;
+	}
+
+	void VideoClip::_swapVideoFrameBuffers(VideoFrame* frame, VideoFrame* other)
+	{
+		if (frame->hasOutputBuffer() && frame->bpp == other->bpp)
+		{
+			frame->_copyPictureFrom(other->buffer, other->pitch);
+			frame->pictureSerial = -1;
+			return;
+		}
+		if (frame->hasOutputBuffer())
+		{
+			Mutex::ScopeLock lock(this->frameQueue->getMutex());
+			frame->_detachOutputBuffer();
+		}
+		std::swap(frame->buffer, other->buffer);
+		std::swap(frame->ownBuffer, other->ownBuffer);
+		std::swap(frame->pitch, other->pitch);
+		std::swap(frame->bpp, other->bpp);
+		std::swap(frame->pictureSerial, other->pictureSerial);
+	}
+
+	void VideoClip::_attachOutputBuffer(VideoFrame* frame)
+	{
+		if (this->freeOutputBuffers.size() == 0 || this->outputBuffersPitch % frame->bpp != 0 || this->outputBuffersPitch < this->width * frame->bpp)
+		{
+			return;
+		}
+		frame->_attachOutputBuffer(this->freeOutputBuffers.front(), this->outputBuffersPitch);
+		this->freeOutputBuffers.erase(this->freeOutputBuffers.begin());
+	}
+
+	void VideoClip::_releaseOutputBuffer(unsigned char* buffer)
+	{
+		if (std::find(this->outputBuffers.begin(), this->outputBuffers.end(), buffer) != this->outputBuffers.end())
+		{
+			this->freeOutputBuffers.push_back(buffer);
+		}
+		if (this->outputBufferReleaseCallback != NULL)
+		{
+			this->outputBufferReleaseCallback(this, buffer, this->outputBufferUserData);
+		}
+	}
+
 }
@@ -0,0 +1,43 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "FrameQueue.h"
+#include "Mutex.h"
+#include "VideoClip.h"
+#include "VideoClipView.h"
+
+namespace theoraplayer
+{
+	VideoClipView::VideoClipView(VideoClip* clip) : frameOffset(0), firstFrameDisplayed(false), displayedFramesCount(0), droppedFramesCount(0)
+	{
+		this->clip = clip;
+	}
+
+	VideoClipView::~VideoClipView()
+	{
+	}
+
+	int VideoClipView::getReadyFramesCount() const
+	{
+		return this->clip->_getReadyFramesCount(this->frameOffset);
+	}
+
+	VideoFrame* VideoClipView::fetchNextFrame()
+	{
+		return this->clip->_fetchNextFrame(this->frameOffset, this->firstFrameDisplayed, this->droppedFramesCount);
+	}
+
+	void VideoClipView::popFrame()
+	{
+		++this->displayedFramesCount;
+		Mutex::ScopeLock lock(this->clip->getFrameQueue()->getMutex());
+		this->clip->_popFrames(this->frameOffset, 1);
+		this->firstFrameDisplayed = true;
+	}
+
+}
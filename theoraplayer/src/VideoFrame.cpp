@@ -6,10 +6,12 @@
 /// This program is free software; you can redistribute it and/or modify it under
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
+#include <algorithm>
 #include <memory.h>
 
 #include "Manager.h"
 #include "PixelTransform.h"
+#include "Utility.h"
 #include "VideoClip.h"
 #include "VideoFrame.h"
 
@@ -38,6 +40,9 @@ extern "C"
 	void decodeYUVX (struct Theoraplayer_PixelTransform* t);
 	void decodeAYUV (struct Theoraplayer_PixelTransform* t);
 	void decodeXYUV (struct Theoraplayer_PixelTransform* t);
+	void decodeRGB565  (struct Theoraplayer_PixelTransform* t);
+	void decodeRGBA4444(struct Theoraplayer_PixelTransform* t);
+	void decodeRGBA5551(struct Theoraplayer_PixelTransform* t);
 }
 
 namespace theoraplayer
@@ -65,15 +70,45 @@ namespace theoraplayer
 		decodeYUVA,
 		decodeYUVX,
 		decodeAYUV,
-		decodeXYUV
+		decodeXYUV,
+		decodeRGB565,
+		decodeRGBA4444,
+		decodeRGBA5551
 	};
 
-	VideoFrame::VideoFrame(VideoClip* clip) : timeToDisplay(0.0f), ready(false), inUse(false), iteration(0), bpp(0), clip(NULL), buffer(NULL), frameNumber(0)
+	static bool _isBlockVisible(const unsigned char* alpha, int stride, int width, int height)
+	{
+		// alpha luma up to 16 is fully transparent, four samples are checked at once: adding 0x6F sets the top bit of samples from 17 to
+		// 0x90 and samples above that have it set already, a carry into the next sample only happens if the sample itself is visible
+		unsigned int word = 0;
+		int x = 0;
+		for (int y = 0; y < height; ++y, alpha += stride)
+		{
+			for (x = 0; x + 4 <= width; x += 4)
+			{
+				memcpy(&word, alpha + x, 4);
+				if (((word + 0x6F6F6F6F) | word) & 0x80808080)
+				{
+					return true;
+				}
+			}
+			for (; x < width; ++x)
+			{
+				if (alpha[x] > 16)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	VideoFrame::VideoFrame(VideoClip* clip) : timeToDisplay(0.0f), ready(false), inUse(false), leasesCount(0), iteration(0), timestampOnly(false), bpp(0), clip(NULL), buffer(NULL), ownBuffer(NULL),
+		pitch(0), frameNumber(0),
+		dirtyMacroblocks(NULL), hasDirtyMacroblocks(false), pictureSerial(-1)
 	{
 		this->clip = clip;
-		// number of bytes based on output mode
-		int bytemap[] = { 0, 3, 4, 4, 4, 4, 3, 4, 4, 4, 4, 1, 3, 4, 4, 4, 4, 3, 4, 4, 4, 4 };
-		this->bpp = bytemap[this->clip->getOutputMode()];
+		this->bpp = getBytesPerPixel(this->clip->getOutputMode());
 		int bufferSize = this->clip->getStride() * this->clip->getHeight() * this->bpp;
 		try
 		{
@@ -85,13 +120,20 @@ namespace theoraplayer
 			return;
 		}
 		memset(this->buffer, 0, bufferSize);
+		this->ownBuffer = this->buffer;
+		this->pitch = this->_getOwnPitch();
 	}
 
 	VideoFrame::~VideoFrame()
 	{
-		if (this->buffer != NULL)
+		this->_detachOutputBuffer();
+		if (this->ownBuffer != NULL)
 		{
-			delete[] this->buffer;
+			delete[] this->ownBuffer;
+		}
+		if (this->dirtyMacroblocks != NULL)
+		{
+			delete[] this->dirtyMacroblocks;
 		}
 	}
 
@@ -115,6 +157,16 @@ namespace theoraplayer
 		return this->clip->hasAlphaChannel();
 	}
 
+	int VideoFrame::getMacroblocksCountX() const
+	{
+		return (this->clip->getWidth() + 15) / 16;
+	}
+
+	int VideoFrame::getMacroblocksCountY() const
+	{
+		return (this->clip->getHeight() + 15) / 16;
+	}
+
 	void VideoFrame::initSpecial(float timeToDisplay, int iteration, unsigned long frameNumber)
 	{
 		this->timeToDisplay = timeToDisplay;
@@ -126,32 +178,15 @@ namespace theoraplayer
 	{
 		if (t->raw != NULL)
 		{
-			unsigned int bufferStride = this->clip->getWidth() * this->bpp;
-			if (bufferStride == t->stride)
-			{
-				memcpy(this->buffer, t->raw, t->stride * this->clip->getHeight());
-			}
-			else
-			{
-				unsigned char* buff = this->buffer;
-				unsigned char* src = t->raw;
-				int i;
-				int h = this->clip->getHeight();
-				for (i = 0; i < h; ++i, buff += bufferStride, src += t->stride)
-				{
-					memcpy(buff, src, bufferStride);
-				}
-			}
+			this->_copyPictureFrom(t->raw, t->stride);
 		}
 		else
 		{
 			t->out = this->buffer;
+			t->dither = (this->clip->isDithering() ? 1 : 0);
+			t->premultiply = (this->clip->isPremultipliedAlpha() ? 1 : 0);
 			t->w = this->clip->getWidth();
-			t->stride = this->clip->getStride();
-			if (this->clip->hasAlphaChannel())
-			{
-				t->stride /= 2;
-			}
+			t->stride = this->pitch / this->bpp;
 			t->h = this->clip->getHeight();
 #ifdef YUV_TEST // when benchmarking yuv conversion functions during development, do a timed average
 #define N 1000
@@ -165,16 +200,179 @@ namespace theoraplayer
 			sprintf(s, "%.2f", diff / N);
 			Manager::getSingleton().logMessage("YUV Decoding time: " + std::string(s) + " ms\n");
 #else
-			conversion_functions[this->clip->getOutputMode()](t);
+			OutputMode outputMode = this->clip->getOutputMode();
+			// YUV output keeps the colors of transparent pixels, they aren't known to be unused
+			if (this->clip->hasAlphaChannel() && outputMode != FORMAT_YUVA && outputMode != FORMAT_AYUV)
+			{
+				this->_decodeVisibleBlocks(t);
+			}
+			else
+			{
+				conversion_functions[outputMode](t);
+			}
 #endif
 		}
+		this->pictureSerial = -1;
+		this->ready = true;
+	}
+
+	void VideoFrame::decodeMacroblocks(struct Theoraplayer_PixelTransform* t, const unsigned char* macroblocks)
+	{
+		int countX = this->getMacroblocksCountX();
+		int countY = this->getMacroblocksCountY();
+		int width = this->clip->getWidth();
+		int height = this->clip->getHeight();
+		struct Theoraplayer_PixelTransform block = *t;
+		block.stride = this->pitch / this->bpp;
+		block.dither = (this->clip->isDithering() ? 1 : 0);
+		block.premultiply = (this->clip->isPremultipliedAlpha() ? 1 : 0);
+		int chromaShiftX = (t->chroma == THEORAPLAYER_CHROMA_444 ? 0 : 1);
+		int chromaShiftY = (t->chroma == THEORAPLAYER_CHROMA_420 ? 1 : 0);
+		int x = 0;
+		int y = 0;
+		int first = 0;
+		for (int row = 0; row < countY; ++row, macroblocks += countX)
+		{
+			for (int column = 0; column < countX; )
+			{
+				if (macroblocks[column] == 0)
+				{
+					++column;
+					continue;
+				}
+				// a run of neighbouring blocks is converted in one call
+				for (first = column; column < countX && macroblocks[column] != 0; ++column);
+				x = first * 16;
+				y = row * 16;
+				block.y = t->y + y * (int)t->yStride + x;
+				block.u = t->u + (y >> chromaShiftY) * (int)t->uStride + (x >> chromaShiftX);
+				block.v = t->v + (y >> chromaShiftY) * (int)t->vStride + (x >> chromaShiftX);
+				block.out = this->buffer + y * this->pitch + x * this->bpp;
+				block.w = std::min(column * 16, width) - x;
+				block.h = std::min(y + 16, height) - y;
+				conversion_functions[this->clip->getOutputMode()](&block);
+			}
+		}
 		this->ready = true;
 	}
 
+	void VideoFrame::_decodeVisibleBlocks(struct Theoraplayer_PixelTransform* t)
+	{
+		void(*convert)(struct Theoraplayer_PixelTransform*) = conversion_functions[this->clip->getOutputMode()];
+		unsigned int alphaOffset = (t->alphaOffset != 0 ? t->alphaOffset : t->w);
+		struct Theoraplayer_PixelTransform block = *t;
+		block.alphaOffset = alphaOffset;
+		int chromaShiftX = (t->chroma == THEORAPLAYER_CHROMA_444 ? 0 : 1);
+		int chromaShiftY = (t->chroma == THEORAPLAYER_CHROMA_420 ? 1 : 0);
+		int width = (int)t->w;
+		int height = (int)t->h;
+		int pitch = (int)t->stride * this->bpp;
+		int countX = (width + 15) / 16;
+		int first = 0;
+		int x = 0;
+		bool visible = false;
+		for (int y = 0; y < height; y += 16)
+		{
+			const unsigned char* alpha = t->y + y * (int)t->yStride + alphaOffset;
+			block.h = std::min(y + 16, height) - y;
+			for (int column = 0; column < countX; )
+			{
+				// a run of neighbouring blocks that are all visible or all transparent is handled in one go
+				first = column;
+				visible = _isBlockVisible(alpha + first * 16, t->yStride, std::min(16, width - first * 16), block.h);
+				for (++column; column < countX && _isBlockVisible(alpha + column * 16, t->yStride, std::min(16, width - column * 16), block.h) == visible; ++column);
+				x = first * 16;
+				block.w = std::min(column * 16, width) - x;
+				block.out = t->out + y * pitch + x * this->bpp;
+				if (!visible)
+				{
+					for (unsigned int i = 0; i < block.h; ++i)
+					{
+						memset(block.out + i * pitch, 0, block.w * this->bpp);
+					}
+					continue;
+				}
+				block.y = t->y + y * (int)t->yStride + x;
+				block.u = t->u + (y >> chromaShiftY) * (int)t->uStride + (x >> chromaShiftX);
+				block.v = t->v + (y >> chromaShiftY) * (int)t->vStride + (x >> chromaShiftX);
+				convert(&block);
+			}
+		}
+	}
+
 	void VideoFrame::clear()
 	{
 		this->inUse = false;
 		this->ready = false;
+		this->timestampOnly = false;
+		this->hasDirtyMacroblocks = false;
+		this->_detachOutputBuffer();
+	}
+
+	int VideoFrame::_getOwnPitch() const
+	{
+		int stride = this->clip->getStride();
+		if (this->clip->hasAlphaChannel())
+		{
+			stride /= 2;
+		}
+		return (stride * this->bpp);
+	}
+
+	void VideoFrame::_attachOutputBuffer(unsigned char* buffer, int pitch)
+	{
+		this->buffer = buffer;
+		this->pitch = pitch;
+		this->pictureSerial = -1;
+	}
+
+	void VideoFrame::_detachOutputBuffer()
+	{
+		if (this->buffer == this->ownBuffer)
+		{
+			return;
+		}
+		unsigned char* buffer = this->buffer;
+		this->buffer = this->ownBuffer;
+		this->pitch = this->_getOwnPitch();
+		this->pictureSerial = -1;
+		this->clip->_releaseOutputBuffer(buffer);
+	}
+
+	void VideoFrame::_copyPictureFrom(const unsigned char* source, int sourcePitch)
+	{
+		int height = this->clip->getHeight();
+		if (sourcePitch == this->pitch)
+		{
+			memcpy(this->buffer, source, this->pitch * height);
+			return;
+		}
+		int size = std::min(sourcePitch, this->pitch);
+		unsigned char* destination = this->buffer;
+		for (int i = 0; i < height; ++i)
+		{
+			memcpy(destination, source, size);
+			destination += this->pitch;
+			source += sourcePitch;
+		}
+	}
+
+	void VideoFrame::_copyPictureTo(unsigned char* destination, int destinationPitch) const
+	{
+		int height = this->clip->getHeight();
+		if (destinationPitch == this->pitch)
+		{
+			memcpy(destination, this->buffer, this->pitch * height);
+			return;
+		}
+		int size = std::min(destinationPitch, this->pitch);
+		const unsigned char* source = this->buffer;
+		for (int i = 0; i < height; ++i)
+		{
+			memcpy(destination, source, size);
+			destination += destinationPitch;
+			source += this->pitch;
+		}
 	}
 
 }
@@ -55,23 +55,41 @@ namespace theoraplayer
 				{
 					break;
 				}
-				Thread::sleep(100.0f);
+				// the next scrub request has to be picked up within a display frame
+				Thread::sleep(theoraplayer::manager->_hasScrubbingClips() ? 1.0f : 100.0f);
 				continue;
 			}
 			lock.acquire(self->clip->threadAccessMutex);
-			// if user requested seeking, do that then.
-			if (self->clip->seekFrame >= 0)
+			if (self->clip->prerolling)
 			{
-				self->clip->_executeSeek();
+				self->clip->_prerollNextFrame();
+				decoded = false; // pre-rolling is only assigned when there's nothing else to decode
 			}
-			decoded = self->clip->_decodeNextFrame();
-			// TODOth - this is a potential hazard as assignedWorkerThread is set under a VideoManager::workMutex lock, but accessed here under a VideoClip::threadAccessMutex lock
-			if (self->clip->assignedWorkerThread == self)
+			else if (self->clip->scrubFrame >= 0)
 			{
-				self->clip->assignedWorkerThread = NULL;
-				self->clip = NULL;
+				self->clip->_executeScrub();
+				decoded = true;
+			}
+			else if (self->clip->scrubTargetFrame >= 0)
+			{
+				decoded = false; // the scrubbing preview stays on screen until the target gets refined
+			}
+			else
+			{
+				// if user requested seeking, do that then.
+				if (self->clip->seekFrame >= 0)
+				{
+					self->clip->_executeSeek();
+				}
+				decoded = self->clip->_decodeNextFrame();
 			}
 			lock.release();
+			// the clip is released under VideoManager::workMutex, the same lock it was assigned under
+			if (theoraplayer::manager->_finishWork(self, decoded))
+			{
+				delete self->clip; // destroyed while it was being decoded
+			}
+			self->clip = NULL;
 			if (!decoded)
 			{
 				Thread::sleep(1.0f); // this happens when the video frame queue is full.
@@ -29,7 +29,7 @@ void decodeGrey(struct Theoraplayer_PixelTransform* t)
 	unsigned char* yLineEnd;
 	unsigned char* out = t->out;
 	unsigned int y;
-	for (y = 0; y < t->h; ++y, ySrc += t->yStride - t->w)
+	for (y = 0; y < t->h; ++y, ySrc += t->yStride - t->w, out += t->stride - t->w)
 	{
 		for (yLineEnd = ySrc + t->w; ySrc != yLineEnd; ++ySrc, ++out)
 		{
@@ -40,27 +40,35 @@ void decodeGrey(struct Theoraplayer_PixelTransform* t)
 
 void decodeGrey3(struct Theoraplayer_PixelTransform* t)
 {
-	_decodeGrey3(t, t->w * 3, 3);
+	_decodeGrey3(t, t->stride * 3, 3);
 }
 
 void decodeGreyA(struct Theoraplayer_PixelTransform* t)
 {
-	_decodeGrey3(t, t->w * 4, 4);
-	_decodeAlpha(incOut(t, 3), t->w * 4);
+	_decodeGrey3(t, t->stride * 4, 4);
+	_decodeAlpha(incOut(t, 3), t->stride * 4);
+	if (t->premultiply)
+	{
+		_premultiplyAlpha(incOut(t, -3), t->stride * 4, 3);
+	}
 }
 
 void decodeGreyX(struct Theoraplayer_PixelTransform* t)
 {
-	_decodeGrey3(t, t->w * 4, 4);
+	_decodeGrey3(t, t->stride * 4, 4);
 }
 
 void decodeAGrey(struct Theoraplayer_PixelTransform* t)
 {
-	_decodeGrey3(incOut(t, 1), t->w * 4, 4);
-	_decodeAlpha(t, t->w * 4);
+	_decodeGrey3(incOut(t, 1), t->stride * 4, 4);
+	_decodeAlpha(incOut(t, -1), t->stride * 4);
+	if (t->premultiply)
+	{
+		_premultiplyAlpha(t, t->stride * 4, 0);
+	}
 }
 
 void decodeXGrey(struct Theoraplayer_PixelTransform* t)
 {
-	_decodeGrey3(incOut(t, 1), t->w * 4, 4);
+	_decodeGrey3(incOut(t, 1), t->stride * 4, 4);
 }
@@ -0,0 +1,106 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines the template the C converters are generated from.
+
+#ifndef THEORAPLAYER_YUV_C_H
+#define THEORAPLAYER_YUV_C_H
+
+extern "C"
+{
+#include "yuv_util.h"
+}
+
+static const unsigned char noDither[4] = { 0, 0, 0, 0 };
+
+static inline unsigned char _alphaFromLuma(int luma)
+{
+	// because in YCbCr specification, luma values are in the range of [16, 235]
+	return (luma <= 16 ? 0 : (luma >= 235 ? 255 : (unsigned char)(((luma - 16) * 255) / 219)));
+}
+
+static inline int _premultiply(int color, int alpha)
+{
+	return (color * alpha + 127) / 255;
+}
+
+/// @brief Converts the planes two rows and two columns at a time, so every chroma sample of 4:2:0 is only read once. Every combination
+/// of chroma subsampling and pixel format is its own function, so the compiler drops the branches and chroma reads that don't apply.
+/// @note Pixel is the output pixel format. It defines bytesCount, alpha (whether the alpha channel is read from the luma next to the
+/// picture), a Chroma type with what is computed once per chroma sample, chroma(u, v) and write(out, luma, chroma, alphaLuma, dither).
+template <int chromaShiftX, int chromaShiftY, class Pixel>
+static void _decodePlanes(struct Theoraplayer_PixelTransform* t)
+{
+	typename Pixel::Chroma c1;
+	typename Pixel::Chroma c2;
+	typename Pixel::Chroma c3;
+	typename Pixel::Chroma c4;
+	int stride = t->stride * Pixel::bytesCount;
+	int alphaOffset = _getAlphaOffset(t);
+	const unsigned char* dither1 = noDither;
+	const unsigned char* dither2 = noDither;
+	unsigned char* ySrc1;
+	unsigned char* ySrc2;
+	unsigned char* uSrc1;
+	unsigned char* uSrc2;
+	unsigned char* vSrc1;
+	unsigned char* vSrc2;
+	unsigned char* out1;
+	unsigned char* out2;
+	unsigned int x;
+	unsigned int y;
+	for (y = 0; y < t->h; y += 2)
+	{
+		ySrc1 = t->y + y * t->yStride;
+		ySrc2 = ySrc1 + t->yStride;
+		uSrc1 = t->u + (y >> chromaShiftY) * t->uStride;
+		uSrc2 = t->u + ((y + 1) >> chromaShiftY) * t->uStride;
+		vSrc1 = t->v + (y >> chromaShiftY) * t->vStride;
+		vSrc2 = t->v + ((y + 1) >> chromaShiftY) * t->vStride;
+		out1 = t->out + y * stride;
+		out2 = out1 + stride;
+		if (t->dither)
+		{
+			dither1 = ditherMatrix[y & 3];
+			dither2 = ditherMatrix[(y + 1) & 3];
+		}
+		for (x = 0; x < t->w; x += 2, out1 += Pixel::bytesCount * 2, out2 += Pixel::bytesCount * 2)
+		{
+			c1 = Pixel::chroma(uSrc1[x >> chromaShiftX], vSrc1[x >> chromaShiftX]);
+			c2 = (chromaShiftX == 0 ? Pixel::chroma(uSrc1[x + 1], vSrc1[x + 1]) : c1);
+			c3 = (chromaShiftY == 0 ? Pixel::chroma(uSrc2[x >> chromaShiftX], vSrc2[x >> chromaShiftX]) : c1);
+			c4 = (chromaShiftY == 0 ? (chromaShiftX == 0 ? Pixel::chroma(uSrc2[x + 1], vSrc2[x + 1]) : c3) : c2);
+			Pixel::write(out1, ySrc1[x], c1, (Pixel::alpha ? ySrc1[x + alphaOffset] : 255), dither1[x & 3]);
+			Pixel::write(out1 + Pixel::bytesCount, ySrc1[x + 1], c2, (Pixel::alpha ? ySrc1[x + 1 + alphaOffset] : 255), dither1[(x + 1) & 3]);
+			Pixel::write(out2, ySrc2[x], c3, (Pixel::alpha ? ySrc2[x + alphaOffset] : 255), dither2[x & 3]);
+			Pixel::write(out2 + Pixel::bytesCount, ySrc2[x + 1], c4, (Pixel::alpha ? ySrc2[x + 1 + alphaOffset] : 255), dither2[(x + 1) & 3]);
+		}
+	}
+}
+
+/// @brief Picks the conversion for the chroma subsampling of the planes.
+template <class Pixel>
+static void _decode(struct Theoraplayer_PixelTransform* t)
+{
+	if (t->chroma == THEORAPLAYER_CHROMA_444)
+	{
+		_decodePlanes<0, 0, Pixel>(t);
+	}
+	else if (t->chroma == THEORAPLAYER_CHROMA_422)
+	{
+		_decodePlanes<1, 0, Pixel>(t);
+	}
+	else
+	{
+		_decodePlanes<1, 1, Pixel>(t);
+	}
+}
+
+#endif
@@ -0,0 +1,297 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#ifdef _YUV_C
+#include "yuv_c.h"
+
+static int YTable[256];
+static int BUTable[256];
+static int GUTable[256];
+static int GVTable[256];
+static int RVTable[256];
+
+static inline unsigned char _clipRGBColor(int x)
+{
+	int tmp = x >> 13;
+	return (unsigned char)((tmp & ~0xFF) == 0 ? tmp : (-tmp) >> 31);
+}
+
+struct RGBChroma
+{
+	int rV;
+	int gUV;
+	int bU;
+};
+
+static inline RGBChroma _rgbChroma(int u, int v)
+{
+	RGBChroma result;
+	result.rV = RVTable[v];
+	result.gUV = GUTable[u] + GVTable[v];
+	result.bU = BUTable[u];
+	return result;
+}
+
+/// @brief 8 bit channels at the given byte offsets, a negative alpha offset means there is no alpha channel.
+template <int bytes, int r, int g, int b, int a, bool premultiplied = false>
+struct RGBPixel
+{
+	enum
+	{
+		bytesCount = bytes,
+		alpha = (a >= 0)
+	};
+	typedef RGBChroma Chroma;
+
+	static inline Chroma chroma(int u, int v)
+	{
+		return _rgbChroma(u, v);
+	}
+
+	static inline void write(unsigned char* out, int luma, const Chroma& c, int alphaLuma, int dither)
+	{
+		// the 'trick' with alpha is that it skips decoding YUV pixels if the alpha value is 0, thus improving the decoding speed of a frame
+		if (a >= 0 && alphaLuma <= 16)
+		{
+			out[0] = out[1] = out[2] = out[3] = 0;
+			return;
+		}
+		int rgbY = YTable[luma];
+		out[r] = _clipRGBColor(rgbY + c.rV);
+		out[g] = _clipRGBColor(rgbY - c.gUV);
+		out[b] = _clipRGBColor(rgbY + c.bU);
+		if (a >= 0)
+		{
+			out[a] = _alphaFromLuma(alphaLuma);
+			if (premultiplied && out[a] != 255)
+			{
+				out[r] = (unsigned char)_premultiply(out[r], out[a]);
+				out[g] = (unsigned char)_premultiply(out[g], out[a]);
+				out[b] = (unsigned char)_premultiply(out[b], out[a]);
+			}
+		}
+	}
+};
+
+static inline int _dither(int x, int d)
+{
+	return (x + d > 255 ? 255 : x + d);
+}
+
+struct PackRGB565
+{
+	enum { alpha = 0 };
+	static inline int storedAlpha(int a)
+	{
+		return 255;
+	}
+	static inline unsigned short pack(int r, int g, int b, int a, int d)
+	{
+		return (unsigned short)((_dither(r, d >> 1) >> 3) << 11 | (_dither(g, d >> 2) >> 2) << 5 | (_dither(b, d >> 1) >> 3));
+	}
+};
+
+struct PackRGBA4444
+{
+	enum { alpha = 1 };
+	static inline int storedAlpha(int a)
+	{
+		return (a >> 4) * 17;
+	}
+	static inline unsigned short pack(int r, int g, int b, int a, int d)
+	{
+		return (unsigned short)((_dither(r, d) >> 4) << 12 | (_dither(g, d) >> 4) << 8 | (_dither(b, d) >> 4) << 4 | (a >> 4));
+	}
+};
+
+struct PackRGBA5551
+{
+	enum { alpha = 1 };
+	static inline int storedAlpha(int a)
+	{
+		return (a >> 7) * 255;
+	}
+	static inline unsigned short pack(int r, int g, int b, int a, int d)
+	{
+		return (unsigned short)((_dither(r, d >> 1) >> 3) << 11 | (_dither(g, d >> 1) >> 3) << 6 | (_dither(b, d >> 1) >> 3) << 1 | (a >> 7));
+	}
+};
+
+/// @brief Packed 16 bit pixels, stored as native-endian shorts. Premultiplied colors are multiplied by the alpha that fits into the pixel.
+template <class Pack, bool premultiplied = false>
+struct RGB16Pixel
+{
+	enum
+	{
+		bytesCount = 2,
+		alpha = Pack::alpha
+	};
+	typedef RGBChroma Chroma;
+
+	static inline Chroma chroma(int u, int v)
+	{
+		return _rgbChroma(u, v);
+	}
+
+	static inline void write(unsigned char* out, int luma, const Chroma& c, int alphaLuma, int dither)
+	{
+		if (alpha && alphaLuma <= 16)
+		{
+			*((unsigned short*)out) = 0;
+			return;
+		}
+		int rgbY = YTable[luma];
+		int red = _clipRGBColor(rgbY + c.rV);
+		int green = _clipRGBColor(rgbY - c.gUV);
+		int blue = _clipRGBColor(rgbY + c.bU);
+		int a = (alpha ? _alphaFromLuma(alphaLuma) : 255);
+		if (alpha && premultiplied)
+		{
+			int stored = Pack::storedAlpha(a);
+			red = _premultiply(red, stored);
+			green = _premultiply(green, stored);
+			blue = _premultiply(blue, stored);
+		}
+		*((unsigned short*)out) = Pack::pack(red, green, blue, a, dither);
+	}
+};
+
+extern "C"
+{
+	void decodeRGB(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<3, 0, 1, 2, -1> >(t);
+	}
+
+	void decodeRGBA(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGBPixel<4, 0, 1, 2, 3, true> >(t);
+		}
+		else
+		{
+			_decode<RGBPixel<4, 0, 1, 2, 3> >(t);
+		}
+	}
+
+	void decodeRGBX(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<4, 0, 1, 2, -1> >(t);
+	}
+
+	void decodeARGB(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGBPixel<4, 1, 2, 3, 0, true> >(t);
+		}
+		else
+		{
+			_decode<RGBPixel<4, 1, 2, 3, 0> >(t);
+		}
+	}
+
+	void decodeXRGB(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<4, 1, 2, 3, -1> >(t);
+	}
+
+	void decodeBGR(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<3, 2, 1, 0, -1> >(t);
+	}
+
+	void decodeBGRA(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGBPixel<4, 2, 1, 0, 3, true> >(t);
+		}
+		else
+		{
+			_decode<RGBPixel<4, 2, 1, 0, 3> >(t);
+		}
+	}
+
+	void decodeBGRX(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<4, 2, 1, 0, -1> >(t);
+	}
+
+	void decodeABGR(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGBPixel<4, 3, 2, 1, 0, true> >(t);
+		}
+		else
+		{
+			_decode<RGBPixel<4, 3, 2, 1, 0> >(t);
+		}
+	}
+
+	void decodeXBGR(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGBPixel<4, 3, 2, 1, -1> >(t);
+	}
+
+	void decodeRGB565(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<RGB16Pixel<PackRGB565> >(t);
+	}
+
+	void decodeRGBA4444(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGB16Pixel<PackRGBA4444, true> >(t);
+		}
+		else
+		{
+			_decode<RGB16Pixel<PackRGBA4444> >(t);
+		}
+	}
+
+	void decodeRGBA5551(struct Theoraplayer_PixelTransform* t)
+	{
+		if (t->premultiply)
+		{
+			_decode<RGB16Pixel<PackRGBA5551, true> >(t);
+		}
+		else
+		{
+			_decode<RGB16Pixel<PackRGBA5551> >(t);
+		}
+	}
+
+	void initYUVConversionModule()
+	{
+		//used to bring the table into the high side (scale up) so we
+		//can maintain high precision and not use floats (FIXED POINT)
+
+		// this is the pseudocode for yuv->rgb conversion
+		//        r = 1.164*(*ySrc - 16) + 1.596*(cv - 128);
+		//        b = 1.164*(*ySrc - 16)                   + 2.018*(cu - 128);
+		//        g = 1.164*(*ySrc - 16) - 0.813*(cv - 128) - 0.391*(cu - 128);
+
+		double scale = 1L << 13;
+		double temp;
+		int i;
+		for (i = 0; i < 256; ++i)
+		{
+			temp = i - 128;
+			YTable[i] = (int)((1.164 * scale + 0.5) * (i - 16));	//Calc Y component
+			RVTable[i] = (int)((1.596 * scale + 0.5) * temp);		//Calc R component
+			GUTable[i] = (int)((0.391 * scale + 0.5) * temp);		//Calc G u & v components
+			GVTable[i] = (int)((0.813 * scale + 0.5) * temp);
+			BUTable[i] = (int)((2.018 * scale + 0.5) * temp);		//Calc B component
+		}
+	}
+}
+#endif
@@ -0,0 +1,74 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include "yuv_c.h"
+
+struct YUVChroma
+{
+	unsigned char u;
+	unsigned char v;
+};
+
+/// @brief 8 bit channels at the given byte offsets, a negative alpha offset means there is no alpha channel.
+template <int bytes, int y, int u, int v, int a>
+struct YUVPixel
+{
+	enum
+	{
+		bytesCount = bytes,
+		alpha = (a >= 0)
+	};
+	typedef YUVChroma Chroma;
+
+	static inline Chroma chroma(int cu, int cv)
+	{
+		Chroma result;
+		result.u = (unsigned char)cu;
+		result.v = (unsigned char)cv;
+		return result;
+	}
+
+	static inline void write(unsigned char* out, int luma, const Chroma& c, int alphaLuma, int dither)
+	{
+		out[y] = (unsigned char)luma;
+		out[u] = c.u;
+		out[v] = c.v;
+		if (a >= 0)
+		{
+			out[a] = _alphaFromLuma(alphaLuma);
+		}
+	}
+};
+
+extern "C"
+{
+	void decodeYUV(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<YUVPixel<3, 0, 1, 2, -1> >(t);
+	}
+
+	void decodeYUVA(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<YUVPixel<4, 0, 1, 2, 3> >(t);
+	}
+
+	void decodeYUVX(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<YUVPixel<4, 0, 1, 2, -1> >(t);
+	}
+
+	void decodeAYUV(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<YUVPixel<4, 1, 2, 3, 0> >(t);
+	}
+
+	void decodeXYUV(struct Theoraplayer_PixelTransform* t)
+	{
+		_decode<YUVPixel<4, 1, 2, 3, -1> >(t);
+	}
+}
@@ -7,63 +7,330 @@
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
 #ifdef _YUV_LIBYUV
+#include <stdlib.h>
 #include <libyuv.h>
 
 #include "yuv_util.h"
 #include "yuv_libyuv.h"
 
+typedef int (*ARGBConversionFunction)(const uint8* src_argb, int src_stride_argb, uint8* dst, int dst_stride, int width, int height);
+
+// libyuv converts 4:2:2 and 4:4:4 only into some pixel orders, so those are converted into ARGB first
+static void _decodeARGBRow(struct Theoraplayer_PixelTransform* t, unsigned int y, uint8* row)
+{
+	// a single 4:2:0 row is a 4:2:2 row that uses the chroma row it shares with its neighbour
+	unsigned int chromaY = (t->chroma == THEORAPLAYER_CHROMA_420 ? y / 2 : y);
+	if (t->chroma == THEORAPLAYER_CHROMA_444)
+	{
+		I444ToARGB(t->y + y * t->yStride, t->yStride, t->u + y * t->uStride, t->uStride, t->v + y * t->vStride, t->vStride, row, t->w * 4, t->w, 1);
+	}
+	else
+	{
+		I422ToARGB(t->y + y * t->yStride, t->yStride, t->u + chromaY * t->uStride, t->uStride, t->v + chromaY * t->vStride, t->vStride, row, t->w * 4, t->w, 1);
+	}
+}
+
+// one row at a time, so the ARGB row is still in the cache when it's converted into the output
+static void _decodeFromARGB(struct Theoraplayer_PixelTransform* t, int bytesCount, ARGBConversionFunction convert)
+{
+	uint8* row = (uint8*)malloc(t->w * 4);
+	unsigned int y = 0;
+	for (y = 0; y < t->h; ++y)
+	{
+		_decodeARGBRow(t, y, row);
+		convert(row, t->w * 4, t->out + y * t->stride * bytesCount, t->stride * bytesCount, t->w, 1);
+	}
+	free(row);
+}
+
 void decodeRGB(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToRAW(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 3, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToRAW(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 3, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 3, ARGBToRAW);
+	}
+}
+
+static void _premultiply(struct Theoraplayer_PixelTransform* t, int alphaIndex)
+{
+	if (t->premultiply)
+	{
+		if (alphaIndex == 3)
+		{
+			// libyuv only cares that alpha is the last byte, the order of the colors doesn't matter
+			ARGBAttenuate(t->out, t->stride * 4, t->out, t->stride * 4, t->w, t->h);
+		}
+		else
+		{
+			_premultiplyAlpha(t, t->stride * 4, alphaIndex);
+		}
+	}
 }
 
 void decodeRGBA(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToABGR(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToABGR(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToABGR);
+	}
 	_decodeAlpha(incOut(t, 3), t->stride * 4);
+	_premultiply(incOut(t, -3), 3);
 }
 
 void decodeRGBX(struct Theoraplayer_PixelTransform* t)
 {
-    I420ToABGR(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToABGR(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToABGR);
+	}
 }
 
 void decodeARGB(struct Theoraplayer_PixelTransform* t)
 {
-    I420ToBGRA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToBGRA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToBGRA);
+	}
 	_decodeAlpha(t, t->stride * 4);
+	_premultiply(t, 0);
 }
 
 void decodeXRGB(struct Theoraplayer_PixelTransform* t)
 {
-    I420ToBGRA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToBGRA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToBGRA);
+	}
 }
 
 void decodeBGR(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToRGB24(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 3, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToRGB24(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 3, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 3, ARGBToRGB24);
+	}
 }
 
 void decodeBGRA(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToARGB(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToARGB(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBCopy);
+	}
 	_decodeAlpha(incOut(t, 3), t->stride * 4);
+	_premultiply(incOut(t, -3), 3);
 }
 
 void decodeBGRX(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToARGB(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToARGB(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBCopy);
+	}
 }
 
 void decodeABGR(struct Theoraplayer_PixelTransform* t)
 {
-    I420ToRGBA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToRGBA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToRGBA);
+	}
 	_decodeAlpha(t, t->stride * 4);
+	_premultiply(t, 0);
 }
 
 void decodeXBGR(struct Theoraplayer_PixelTransform* t)
 {
-	I420ToRGBA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToRGBA(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 4, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 4, ARGBToRGBA);
+	}
+}
+
+// libyuv's 4x4 dither offsets for RGB565, from 0 to 7
+static const unsigned char dither565[16] = { 0, 4, 1, 5, 6, 2, 7, 3, 1, 5, 0, 4, 7, 3, 6, 2 };
+
+// multiplies the 3 color fields below the alpha bits by the alpha that fits into the pixel
+static unsigned short _premultiply16(unsigned short pixel, int fieldBits, int alpha)
+{
+	int mask = (1 << fieldBits) - 1;
+	int r = (((pixel >> (fieldBits * 2)) & mask) * alpha + 127) / 255;
+	int g = (((pixel >> fieldBits) & mask) * alpha + 127) / 255;
+	int b = ((pixel & mask) * alpha + 127) / 255;
+	return (unsigned short)(r << (fieldBits * 2) | g << fieldBits | b);
+}
+
+// libyuv packs alpha into the top bits, it's moved to the bottom and replaced by the alpha channel next to the picture
+static void _packAlpha16(struct Theoraplayer_PixelTransform* t, int alphaBits)
+{
+	unsigned char* aSrc = NULL;
+	unsigned short* out = NULL;
+	int fieldBits = (16 - alphaBits) / 3;
+	int luma = 0;
+	int alpha = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+	for (y = 0; y < t->h; ++y)
+	{
+		aSrc = t->y + y * t->yStride + _getAlphaOffset(t);
+		out = (unsigned short*)(t->out + y * t->stride * 2);
+		for (x = 0; x < t->w; ++x)
+		{
+			luma = aSrc[x];
+			if (luma <= 16)
+			{
+				out[x] = 0;
+				continue;
+			}
+			luma = (luma >= 235 ? 255 : ((luma - 16) * 255) / 219);
+			alpha = luma >> (8 - alphaBits);
+			if (t->premultiply)
+			{
+				out[x] = _premultiply16(out[x], fieldBits, alpha * 255 / ((1 << alphaBits) - 1));
+			}
+			out[x] = (unsigned short)((out[x] << alphaBits) | alpha);
+		}
+	}
+}
+
+void decodeRGB565(struct Theoraplayer_PixelTransform* t)
+{
+	uint8* row = NULL;
+	unsigned int y = 0;
+	if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		if (t->dither)
+		{
+			I420ToRGB565Dither(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 2, dither565, t->w, t->h);
+		}
+		else
+		{
+			I420ToRGB565(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 2, t->w, t->h);
+		}
+	}
+	else if (t->dither)
+	{
+		row = (uint8*)malloc(t->w * 4);
+		for (y = 0; y < t->h; ++y)
+		{
+			_decodeARGBRow(t, y, row);
+			// the row of dither offsets is picked here since libyuv only sees a single row
+			ARGBToRGB565Dither(row, t->w * 4, t->out + y * t->stride * 2, t->stride * 2, dither565 + (y & 3) * 4, t->w, 1);
+		}
+		free(row);
+	}
+	else
+	{
+		_decodeFromARGB(t, 2, ARGBToRGB565);
+	}
+}
+
+// libyuv has no dithered 4444 and 1555 converters, so dithered rows are packed from ARGB here in the layout libyuv's converters use
+static void _decodeDithered16(struct Theoraplayer_PixelTransform* t, int alphaBits)
+{
+	uint8* row = (uint8*)malloc(t->w * 4);
+	unsigned short* out = NULL;
+	const unsigned char* dither = NULL;
+	int fieldBits = (16 - alphaBits) / 3;
+	int lostBits = 8 - fieldBits;
+	int offset = 0;
+	int r = 0;
+	int g = 0;
+	int b = 0;
+	unsigned int x = 0;
+	unsigned int y = 0;
+	for (y = 0; y < t->h; ++y)
+	{
+		_decodeARGBRow(t, y, row);
+		out = (unsigned short*)(t->out + y * t->stride * 2);
+		dither = ditherMatrix[y & 3];
+		for (x = 0; x < t->w; ++x)
+		{
+			offset = dither[x & 3] >> (4 - lostBits);
+			b = row[x * 4] + offset;
+			g = row[x * 4 + 1] + offset;
+			r = row[x * 4 + 2] + offset;
+			b = (b > 255 ? 255 : b) >> lostBits;
+			g = (g > 255 ? 255 : g) >> lostBits;
+			r = (r > 255 ? 255 : r) >> lostBits;
+			out[x] = (unsigned short)(r << (fieldBits * 2) | g << fieldBits | b);
+		}
+	}
+	free(row);
+}
+
+void decodeRGBA4444(struct Theoraplayer_PixelTransform* t)
+{
+	if (t->dither)
+	{
+		_decodeDithered16(t, 4);
+	}
+	else if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToARGB4444(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 2, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 2, ARGBToARGB4444);
+	}
+	_packAlpha16(t, 4);
+}
+
+void decodeRGBA5551(struct Theoraplayer_PixelTransform* t)
+{
+	if (t->dither)
+	{
+		_decodeDithered16(t, 1);
+	}
+	else if (t->chroma == THEORAPLAYER_CHROMA_420)
+	{
+		I420ToARGB1555(t->y, t->yStride, t->u, t->uStride, t->v, t->vStride, t->out, t->stride * 2, t->w, t->h);
+	}
+	else
+	{
+		_decodeFromARGB(t, 2, ARGBToARGB1555);
+	}
+	_packAlpha16(t, 1);
 }
 
 void initYUVConversionModule()
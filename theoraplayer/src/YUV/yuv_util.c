@@ -7,6 +7,9 @@
 /// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
 
 #include <stdlib.h>
+#ifdef _YUV_LIBYUV
+#include <libyuv.h>
+#endif
 
 #include "yuv_util.h"
 
@@ -17,6 +20,11 @@ struct Theoraplayer_PixelTransform* incOut(struct Theoraplayer_PixelTransform* t
 	return t;
 }
 
+unsigned int _getAlphaOffset(struct Theoraplayer_PixelTransform* t)
+{
+	return (t->alphaOffset != 0 ? t->alphaOffset : t->w);
+}
+
 void _decodeAlpha(struct Theoraplayer_PixelTransform* t, int stride)
 {
 	unsigned char* ySrc = NULL;
@@ -26,7 +34,7 @@ void _decodeAlpha(struct Theoraplayer_PixelTransform* t, int stride)
 	unsigned int y = 0;
 	for (y = 0; y < t->h; y++)
 	{
-		ySrc = t->y + y * t->yStride + t->w;
+		ySrc = t->y + y * t->yStride + _getAlphaOffset(t);
 		out = t->out + y * stride;
 		yLineEnd = ySrc + t->w;
 		while (ySrc != yLineEnd)
@@ -51,3 +59,144 @@ void _decodeAlpha(struct Theoraplayer_PixelTransform* t, int stride)
 		}
 	}
 }
+
+void _premultiplyAlpha(struct Theoraplayer_PixelTransform* t, int stride, int alphaIndex)
+{
+	// the 3 color bytes of a pixel are right after the alpha byte or right before it
+	int first = (alphaIndex == 0 ? 1 : 0);
+	unsigned char* out = NULL;
+	unsigned char* lineEnd = NULL;
+	int alpha = 0;
+	unsigned int y = 0;
+	for (y = 0; y < t->h; ++y)
+	{
+		out = t->out + y * stride;
+		for (lineEnd = out + t->w * 4; out != lineEnd; out += 4)
+		{
+			alpha = out[alphaIndex];
+			if (alpha != 255)
+			{
+				out[first] = (unsigned char)((out[first] * alpha + 127) / 255);
+				out[first + 1] = (unsigned char)((out[first + 1] * alpha + 127) / 255);
+				out[first + 2] = (unsigned char)((out[first + 2] * alpha + 127) / 255);
+			}
+		}
+	}
+}
+
+#ifndef _YUV_LIBYUV
+static void _scalePlaneBox(const unsigned char* src, int srcStride, int srcWidth, int srcHeight, unsigned char* dst, int dstStride, int dstWidth, int dstHeight)
+{
+	// sums of the source rows covered by a destination row, the columns covered by each destination pixel are added up from those
+	unsigned int* sums = (unsigned int*)malloc(srcWidth * sizeof(unsigned int));
+	const unsigned char* row = NULL;
+	unsigned int sum = 0;
+	int x = 0;
+	int y = 0;
+	int i = 0;
+	int x0 = 0;
+	int x1 = 0;
+	int y0 = 0;
+	int y1 = 0;
+	for (y = 0; y < dstHeight; ++y)
+	{
+		y0 = y * srcHeight / dstHeight;
+		y1 = (y + 1) * srcHeight / dstHeight;
+		if (y1 <= y0)
+		{
+			y1 = y0 + 1;
+		}
+		row = src + y0 * srcStride;
+		for (i = 0; i < srcWidth; ++i)
+		{
+			sums[i] = row[i];
+		}
+		for (row += srcStride; row < src + y1 * srcStride; row += srcStride)
+		{
+			for (i = 0; i < srcWidth; ++i)
+			{
+				sums[i] += row[i];
+			}
+		}
+		for (x = 0; x < dstWidth; ++x)
+		{
+			x0 = x * srcWidth / dstWidth;
+			x1 = (x + 1) * srcWidth / dstWidth;
+			if (x1 <= x0)
+			{
+				x1 = x0 + 1;
+			}
+			sum = 0;
+			for (i = x0; i < x1; ++i)
+			{
+				sum += sums[i];
+			}
+			dst[x] = (unsigned char)(sum / ((x1 - x0) * (y1 - y0)));
+		}
+		dst += dstStride;
+	}
+	free(sums);
+}
+
+static void _scalePlaneBilinear(const unsigned char* src, int srcStride, int srcWidth, int srcHeight, unsigned char* dst, int dstStride, int dstWidth, int dstHeight)
+{
+	// 16.16 fixed point source positions of the destination pixel centers
+	int dx = (srcWidth << 16) / dstWidth;
+	int dy = (srcHeight << 16) / dstHeight;
+	int maxX = (srcWidth - 1) << 16;
+	int maxY = (srcHeight - 1) << 16;
+	int fx = 0;
+	int fy = 0;
+	int wx = 0;
+	int wy = 0;
+	int top = 0;
+	int bottom = 0;
+	int x = 0;
+	int y = 0;
+	const unsigned char* row0 = NULL;
+	const unsigned char* row1 = NULL;
+	for (y = 0; y < dstHeight; ++y)
+	{
+		fy = y * dy + dy / 2 - 0x8000;
+		fy = (fy < 0 ? 0 : (fy > maxY ? maxY : fy));
+		row0 = src + (fy >> 16) * srcStride;
+		row1 = ((fy >> 16) < srcHeight - 1 ? row0 + srcStride : row0);
+		wy = (fy >> 8) & 0xFF;
+		for (x = 0; x < dstWidth; ++x)
+		{
+			fx = x * dx + dx / 2 - 0x8000;
+			fx = (fx < 0 ? 0 : (fx > maxX ? maxX : fx));
+			wx = (fx >> 8) & 0xFF;
+			fx >>= 16;
+			if (fx < srcWidth - 1)
+			{
+				top = row0[fx] * (256 - wx) + row0[fx + 1] * wx;
+				bottom = row1[fx] * (256 - wx) + row1[fx + 1] * wx;
+			}
+			else
+			{
+				top = row0[fx] << 8;
+				bottom = row1[fx] << 8;
+			}
+			dst[x] = (unsigned char)((top * (256 - wy) + bottom * wy + 0x8000) >> 16);
+		}
+		dst += dstStride;
+	}
+}
+#endif
+
+void scalePlane(const unsigned char* src, int srcStride, int srcWidth, int srcHeight, unsigned char* dst, int dstStride, int dstWidth, int dstHeight, int filter)
+{
+#ifdef _YUV_LIBYUV
+	ScalePlane(src, srcStride, srcWidth, srcHeight, dst, dstStride, dstWidth, dstHeight, (filter == 0 ? kFilterBox : kFilterBilinear));
+#else
+	if (filter == 0)
+	{
+		_scalePlaneBox(src, srcStride, srcWidth, srcHeight, dst, dstStride, dstWidth, dstHeight);
+	}
+	else
+	{
+		_scalePlaneBilinear(src, srcStride, srcWidth, srcHeight, dst, dstStride, dstWidth, dstHeight);
+	}
+#endif
+}
@@ -11,7 +11,24 @@
 
 #include "PixelTransform.h"
 
+// 4x4 ordered dither thresholds from 0 to 15, each pixel format scales them down to the precision it loses
+static const unsigned char ditherMatrix[4][4] =
+{
+	{ 0, 8, 2, 10 },
+	{ 12, 4, 14, 6 },
+	{ 3, 11, 1, 9 },
+	{ 15, 7, 13, 5 }
+};
+
 struct Theoraplayer_PixelTransform* incOut(struct Theoraplayer_PixelTransform* t, int n);
+/// @return Distance from a luma sample to its alpha sample.
+unsigned int _getAlphaOffset(struct Theoraplayer_PixelTransform* t);
 void _decodeAlpha(struct Theoraplayer_PixelTransform* t, int stride);
+/// @brief Multiplies the colors of 4 byte pixels by their alpha.
+/// @param[in] alphaIndex 0 if alpha is the first byte of a pixel, 3 if it's the last one.
+void _premultiplyAlpha(struct Theoraplayer_PixelTransform* t, int stride, int alphaIndex);
+/// @brief Scales an 8 bit plane, used to downscale the YUV planes before conversion.
+/// @param[in] filter 0 averages all source pixels covered by a destination pixel, 1 interpolates bilinearly.
+void scalePlane(const unsigned char* src, int srcStride, int srcWidth, int srcHeight, unsigned char* dst, int dstStride, int dstWidth, int dstHeight, int filter);
 
 #endif
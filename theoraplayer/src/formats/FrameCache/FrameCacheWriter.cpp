@@ -0,0 +1,129 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <algorithm>
+#include <memory.h>
+
+#include "FrameCacheWriter.h"
+#include "theoraplayer.h"
+#include "VideoClip.h"
+#include "VideoFrame.h"
+
+namespace theoraplayer
+{
+	FrameCacheWriter::FrameCacheWriter(const std::string& filename, uint64_t sourceHash, bool usePotStride)
+	{
+		this->filename = filename;
+		this->file = NULL;
+		memset(&this->header, 0, sizeof(FrameCacheHeader));
+		memcpy(this->header.magic, "TPFC", 4);
+		this->header.version = FRAME_CACHE_VERSION;
+		this->header.usePotStride = (usePotStride ? 1 : 0);
+		this->header.sourceHash = sourceHash;
+		this->nextFrame = 0;
+		this->finished = false;
+	}
+
+	FrameCacheWriter::~FrameCacheWriter()
+	{
+		if (this->file != NULL)
+		{
+			fclose(this->file);
+			this->file = NULL;
+		}
+		if (!this->finished)
+		{
+			remove(this->filename.c_str());
+		}
+	}
+
+	bool FrameCacheWriter::write(VideoClip* clip, VideoFrame* frame, int frameSize)
+	{
+		if (this->finished)
+		{
+			return true;
+		}
+		if (this->file == NULL)
+		{
+			if (clip->getFramesCount() <= 0)
+			{
+				return false;
+			}
+			this->file = fopen(this->filename.c_str(), "wb");
+			if (this->file == NULL)
+			{
+				log("Unable to create frame cache: " + this->filename);
+				return false;
+			}
+			this->header.complete = 0;
+			this->header.outputMode = (int)clip->getOutputMode();
+			this->header.width = clip->getWidth();
+			this->header.height = clip->getHeight();
+			this->header.stride = clip->getStride();
+			this->header.subFrameX = clip->getSubFrameX();
+			this->header.subFrameY = clip->getSubFrameY();
+			this->header.subFrameWidth = clip->getSubFrameWidth();
+			this->header.subFrameHeight = clip->getSubFrameHeight();
+			this->header.framesCount = clip->getFramesCount();
+			this->header.frameSize = frameSize;
+			this->header.fps = clip->getFps();
+			if (fwrite(&this->header, 1, sizeof(FrameCacheHeader), this->file) != sizeof(FrameCacheHeader))
+			{
+				return false;
+			}
+		}
+		if (this->header.outputMode != (int)clip->getOutputMode() || this->header.frameSize != frameSize)
+		{
+			return false;
+		}
+		if (frame->getFrameNumber() != (unsigned long)this->nextFrame)
+		{
+			if (frame->getFrameNumber() != 0)
+			{
+				return true; // wait for the start of the next iteration
+			}
+			fseek(this->file, sizeof(FrameCacheHeader), SEEK_SET);
+			this->nextFrame = 0;
+		}
+		const unsigned char* data = frame->getBuffer();
+		if (frame->hasOutputBuffer())
+		{
+			int height = clip->getHeight();
+			int pitch = frameSize / height;
+			int size = std::min(pitch, frame->getPitch());
+			this->frameBuffer.resize(frameSize, 0);
+			for (int i = 0; i < height; ++i)
+			{
+				memcpy(&this->frameBuffer[i * pitch], data + i * frame->getPitch(), size);
+			}
+			data = &this->frameBuffer[0];
+		}
+		if (fwrite(data, 1, frameSize, this->file) != (size_t)frameSize)
+		{
+			log("Unable to write frame cache: " + this->filename);
+			return false;
+		}
+		++this->nextFrame;
+		if (this->nextFrame >= this->header.framesCount)
+		{
+			this->header.complete = 1;
+			fseek(this->file, 0, SEEK_SET);
+			bool written = (fwrite(&this->header, 1, sizeof(FrameCacheHeader), this->file) == sizeof(FrameCacheHeader));
+			written &= (fclose(this->file) == 0);
+			this->file = NULL;
+			if (!written)
+			{
+				return false;
+			}
+			this->finished = true;
+			log("Frame cache written: " + this->filename);
+		}
+		return true;
+	}
+
+}
@@ -0,0 +1,56 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Defines a writer that stores converted frames of a clip in a frame cache file.
+
+#ifndef THEORAPLAYER_FRAME_CACHE_WRITER_H
+#define THEORAPLAYER_FRAME_CACHE_WRITER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "VideoClip_FrameCache.h"
+
+namespace theoraplayer
+{
+	class VideoClip;
+	class VideoFrame;
+
+	/// @brief Writes the frames of one iteration of a clip to a file that VideoClip_FrameCache can play back.
+	/// Frames have to arrive in order, starting with frame 0. If a frame is skipped (eg. dropped or after a seek),
+	/// writing starts over with the next frame 0.
+	class FrameCacheWriter
+	{
+	public:
+		FrameCacheWriter(const std::string& filename, uint64_t sourceHash, bool usePotStride);
+		/// @note An unfinished cache file is deleted.
+		~FrameCacheWriter();
+
+		inline bool isFinished() const { return this->finished; }
+
+		/// @brief Writes a decoded frame of size frameSize bytes.
+		/// @return False if the cache can't be written, in which case the writer should be discarded.
+		bool write(VideoClip* clip, VideoFrame* frame, int frameSize);
+
+	protected:
+		std::string filename;
+		FILE* file;
+		FrameCacheHeader header;
+		int nextFrame;
+		bool finished;
+		/// @brief Frames in output buffers are copied to the pitch of the file here first.
+		std::vector<unsigned char> frameBuffer;
+
+	};
+
+}
+#endif
@@ -0,0 +1,215 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+
+#include <algorithm>
+#include <memory.h>
+#include <stdio.h>
+
+#include "DataSource.h"
+#include "Exception.h"
+#include "FrameQueue.h"
+#include "theoraplayer.h"
+#include "Timer.h"
+#include "Utility.h"
+#include "VideoClip_FrameCache.h"
+#include "VideoFrame.h"
+
+#define BUFFER_SIZE 65536
+
+namespace theoraplayer
+{
+	VideoClip_FrameCache::VideoClip_FrameCache(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride) :
+		VideoClip(dataSource, outputMode, precachedFramesCount, usePotStride)
+	{
+		memset(&this->header, 0, sizeof(FrameCacheHeader));
+		this->currentFrame = 0;
+	}
+
+	VideoClip_FrameCache::~VideoClip_FrameCache()
+	{
+	}
+
+	VideoClip* VideoClip_FrameCache::create(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride)
+	{
+		return new VideoClip_FrameCache(dataSource, outputMode, precachedFramesCount, usePotStride);
+	}
+
+	uint64_t VideoClip_FrameCache::calculateHash(DataSource* dataSource)
+	{
+		// 64 bit FNV-1a
+		uint64_t hash = 14695981039346656037ULL;
+		unsigned char* buffer = new unsigned char[BUFFER_SIZE];
+		int bytesRead = 0;
+		dataSource->seek(0);
+		while ((bytesRead = dataSource->read(buffer, BUFFER_SIZE)) > 0)
+		{
+			for (int i = 0; i < bytesRead; ++i)
+			{
+				hash = (hash ^ buffer[i]) * 1099511628211ULL;
+			}
+		}
+		dataSource->seek(0);
+		delete[] buffer;
+		return hash;
+	}
+
+	bool VideoClip_FrameCache::isValid(const std::string& filename, uint64_t sourceHash, OutputMode outputMode, bool usePotStride)
+	{
+		FILE* file = fopen(filename.c_str(), "rb");
+		if (file == NULL)
+		{
+			return false;
+		}
+		FrameCacheHeader header;
+		bool result = (fread(&header, 1, sizeof(FrameCacheHeader), file) == sizeof(FrameCacheHeader) && memcmp(header.magic, "TPFC", 4) == 0 &&
+			header.version == FRAME_CACHE_VERSION && header.complete != 0 && header.sourceHash == sourceHash &&
+			header.outputMode == (int)outputMode && (header.usePotStride != 0) == usePotStride);
+		fclose(file);
+		return result;
+	}
+
+	void VideoClip_FrameCache::_load(DataSource* source)
+	{
+		this->stream = source;
+		this->stream->seek(0);
+		if (this->stream->read(&this->header, sizeof(FrameCacheHeader)) != sizeof(FrameCacheHeader) || memcmp(this->header.magic, "TPFC", 4) != 0 ||
+			this->header.version != FRAME_CACHE_VERSION || this->header.complete == 0)
+		{
+			throw TheoraplayerException("Invalid or incomplete frame cache: " + this->name);
+		}
+		if (this->header.outputMode != (int)this->outputMode)
+		{
+			throw TheoraplayerException("Frame cache " + this->name + " was not created for the requested output mode!");
+		}
+		this->width = this->header.width;
+		this->height = this->header.height;
+		this->stride = this->header.stride;
+		this->subFrameX = this->header.subFrameX;
+		this->subFrameY = this->header.subFrameY;
+		this->subFrameWidth = this->header.subFrameWidth;
+		this->subFrameHeight = this->header.subFrameHeight;
+		this->framesCount = this->header.framesCount;
+		this->fps = this->header.fps;
+		this->frameDuration = 1.0f / this->fps;
+		this->duration = this->framesCount / this->fps;
+		this->frameQueue = new FrameQueue(this);
+		this->frameQueue->setSize(this->precachedFramesCount);
+#ifdef _DEBUG
+		log("width: " + str(this->width) + ", height: " + str(this->height) + ", fps: " + str((int)this->getFps()) + ", frames: " + str(this->framesCount));
+#endif
+	}
+
+	bool VideoClip_FrameCache::_readData()
+	{
+		return (this->currentFrame < this->framesCount);
+	}
+
+	bool VideoClip_FrameCache::_decodeNextFrame()
+	{
+		if (this->endOfFile)
+		{
+			return false;
+		}
+		VideoFrame* frame = this->frameQueue->requestEmptyFrame();
+		if (frame == NULL)
+		{
+			return false; // max number of precached frames reached
+		}
+		if (this->outputMode != (OutputMode)this->header.outputMode)
+		{
+			// frames are stored already converted, so there is no way to provide a different output mode
+			log(this->name + ": output mode can't be changed in a frame cache");
+			this->_setVideoFrameInUse(frame, false);
+			this->endOfFile = true;
+			return false;
+		}
+		if (this->trickPlayReverse)
+		{
+			if (this->currentFrame < 0)
+			{
+				this->_setVideoFrameInUse(frame, false);
+				this->endOfFile = true;
+				log(this->name + " finished playing");
+				return false;
+			}
+		}
+		else if (!this->_readData())
+		{
+			if (!this->autoRestart)
+			{
+				this->_setVideoFrameInUse(frame, false);
+				this->endOfFile = true;
+				log(this->name + " finished playing");
+				return false;
+			}
+			++this->iteration;
+			this->_executeRestart();
+		}
+		if (this->visibility == VISIBILITY_TIMESTAMPS_ONLY)
+		{
+			this->_setVideoFrameTimestampOnly(frame, true);
+		}
+		else
+		{
+			// frames are stored back to back, reading from a MappedFileDataSource is a copy straight from the mapping
+			int64_t position = sizeof(FrameCacheHeader) + (int64_t)this->currentFrame * this->header.frameSize;
+			if (!frame->hasOutputBuffer())
+			{
+				this->stream->seek(position);
+				this->stream->read(frame->getBuffer(), this->header.frameSize);
+			}
+			else
+			{
+				// output buffers can have a different pitch than the file
+				int pitch = this->header.frameSize / this->height;
+				int size = std::min(pitch, frame->getPitch());
+				unsigned char* buffer = frame->getBuffer();
+				for (int i = 0; i < this->height; ++i, buffer += frame->getPitch())
+				{
+					this->stream->seek(position + (int64_t)i * pitch);
+					this->stream->read(buffer, size);
+				}
+			}
+		}
+		this->_setVideoFrameTimeToDisplay(frame, this->currentFrame * this->frameDuration);
+		this->_setVideoFrameIteration(frame, this->iteration);
+		this->_setVideoFrameFrameNumber(frame, this->currentFrame);
+		this->_setVideoFrameReady(frame, true);
+		// every frame can be read on its own, so playing backwards doesn't need any buffering
+		this->currentFrame += (this->trickPlayReverse ? -1 : 1);
+		return true;
+	}
+
+	float VideoClip_FrameCache::_decodeAudio()
+	{
+		return -1.0f;
+	}
+
+	void VideoClip_FrameCache::_decodedAudioCheck()
+	{
+	}
+
+	void VideoClip_FrameCache::_executeSeek()
+	{
+		this->_applyTrickPlayMode(); // every frame costs the same, so only the direction matters
+		this->timer->seek(this->seekFrame / this->getFps());
+		this->endOfFile = false;
+		this->restarted = false;
+		this->_resetFrameQueue();
+		this->currentFrame = (this->seekFrame < this->framesCount ? this->seekFrame : this->framesCount - 1);
+		this->seekFrame = -1;
+	}
+
+	void VideoClip_FrameCache::_executeRestart()
+	{
+		this->currentFrame = 0;
+		this->endOfFile = false;
+		this->restarted = true;
+	}
+
+}
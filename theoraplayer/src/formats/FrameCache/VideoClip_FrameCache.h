@@ -0,0 +1,83 @@
+/// @file
+/// @version 2.0
+/// 
+/// @section LICENSE
+/// 
+/// This program is free software; you can redistribute it and/or modify it under
+/// the terms of the BSD license: http://opensource.org/licenses/BSD-3-Clause
+/// 
+/// @section DESCRIPTION
+/// 
+/// Implements playback of frames that were already converted to an output mode and stored in a cache file.
+
+#ifndef THEORAPLAYER_VIDEO_CLIP_FRAME_CACHE_H
+#define THEORAPLAYER_VIDEO_CLIP_FRAME_CACHE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "DataSource.h"
+#include "Utility.h"
+#include "VideoClip.h"
+
+#define FRAME_CACHE_EXTENSION ".tpfc"
+#define FRAME_CACHE_VERSION 1
+
+namespace theoraplayer
+{
+	/// @brief Header at the start of a frame cache file. Frames follow directly after it, frameSize bytes each.
+	/// @note Values are stored in native byte order, cache files are meant to be used only on the machine that wrote them.
+	struct FrameCacheHeader
+	{
+		char magic[4];
+		int version;
+		/// @brief Set once all frames have been written.
+		int complete;
+		int outputMode;
+		int usePotStride;
+		int width;
+		int height;
+		int stride;
+		int subFrameX;
+		int subFrameY;
+		int subFrameWidth;
+		int subFrameHeight;
+		int framesCount;
+		int frameSize;
+		float fps;
+		int reserved;
+		/// @brief Hash of the video file the frames were decoded from.
+		uint64_t sourceHash;
+	};
+
+	class VideoClip_FrameCache : public VideoClip
+	{
+	public:
+		VideoClip_FrameCache(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride);
+		~VideoClip_FrameCache();
+
+		std::string getDecoderName() const { return FRAME_CACHE_FORMAT_NAME; }
+
+		static VideoClip* create(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride);
+		/// @return Hash of the entire contents of the data source, used to detect whether a cache belongs to a video file.
+		static uint64_t calculateHash(DataSource* dataSource);
+		/// @return Whether filename is a complete frame cache of the video with the given hash, output mode and stride.
+		static bool isValid(const std::string& filename, uint64_t sourceHash, OutputMode outputMode, bool usePotStride);
+
+	protected:
+		FrameCacheHeader header;
+		/// @brief Number of the next frame that will be read.
+		int currentFrame;
+
+		void _load(DataSource* source);
+		bool _readData();
+		bool _decodeNextFrame();
+		float _decodeAudio();
+		void _decodedAudioCheck();
+		void _executeSeek();
+		void _executeRestart();
+
+	};
+
+}
+#endif
@@ -8,6 +8,7 @@
 
 #ifdef _USE_THEORA
 #include <algorithm>
+#include <map>
 #include <memory.h>
 #include <string>
 #include <stdint.h>
@@ -26,7 +27,19 @@
 #include "VideoClip_Theora.h"
 #include "VideoFrame.h"
 
+extern "C"
+{
+	void scalePlane(const unsigned char* src, int srcStride, int srcWidth, int srcHeight, unsigned char* dst, int dstStride, int dstWidth, int dstHeight, int filter);
+}
+
 #define BUFFER_SIZE 4096
+// number of pictures whose changed macroblocks are kept for incremental conversion
+#define DIRTY_HISTORY_SIZE 32
+
+//#define _SEEK_BENCHMARK // uncomment to log how long seeks and loop transitions take
+#ifdef _SEEK_BENCHMARK
+#include <time.h>
+#endif
 
 #ifdef _USE_TREMOR
 static inline int32_t CLIP_TO_15(int32_t x)
@@ -48,16 +61,57 @@ extern "C"
 
 namespace theoraplayer
 {
+	// headers of all currently loaded assets, indexed by asset identity
+	static std::map<std::string, TheoraSharedHeaders*> sharedHeadersCache;
+	static Mutex sharedHeadersMutex;
+
+	// prepares the conversion of the planes, the chroma subsampling is told by the size of the chroma planes
+	static void _setPixelTransformPlanes(Theoraplayer_PixelTransform* pixelTransform, th_ycbcr_buffer buffer)
+	{
+		memset(pixelTransform, 0, sizeof(Theoraplayer_PixelTransform));
+		pixelTransform->y = buffer[0].data;	pixelTransform->yStride = buffer[0].stride;
+		pixelTransform->u = buffer[1].data;	pixelTransform->uStride = buffer[1].stride;
+		pixelTransform->v = buffer[2].data;	pixelTransform->vStride = buffer[2].stride;
+		pixelTransform->chroma = THEORAPLAYER_CHROMA_420;
+		if (buffer[1].height == buffer[0].height)
+		{
+			pixelTransform->chroma = (buffer[1].width == buffer[0].width ? THEORAPLAYER_CHROMA_444 : THEORAPLAYER_CHROMA_422);
+		}
+	}
+
 	VideoClip_Theora::VideoClip_Theora(DataSource* data_source, OutputMode output_mode, int nPrecachedFrames, bool usePower2Stride) :
 		VideoClip(data_source, output_mode, nPrecachedFrames, usePower2Stride),
 		AudioPacketQueue()
 	{
 		this->info.TheoraDecoder = NULL;
 		this->info.TheoraSetup = NULL;
+		this->sharedHeaders = NULL;
 		this->vorbisStreams = 0;
 		this->theoraStreams = 0;
 		this->readAudioSamples = 0;
 		this->lastDecodedFrameNumber = 0;
+		this->decoderPostProcessingLevel = 0;
+		this->preroll.TheoraDecoder = NULL;
+		this->preroll.stream = NULL;
+		this->preroll.decoderPostProcessingLevel = 0;
+		this->preroll.requested = false;
+		this->preroll.active = false;
+		this->preroll.outputMode = FORMAT_UNDEFINED;
+		this->preroll.decodedFramesCount = 0;
+		this->preroll.deliveredFramesCount = -1;
+		this->checkpointsSize = 0;
+		this->skippedPacketsCount = 0;
+		this->reverseOutputMode = FORMAT_UNDEFINED;
+		this->reverseFramesCount = 0;
+		this->reverseFrame = -1;
+		this->dirtyTracking = false;
+		this->pictureSerial = 0;
+		this->dirtyBaseSerial = 1;
+		this->queuedPictureSerial = -1;
+		this->cropX = 0;
+		this->cropY = 0;
+		this->cropWidth = 0;
+		this->cropHeight = 0;
 	}
 
 	VideoClip* VideoClip_Theora::create(DataSource* dataSource, OutputMode outputMode, int precachedFramesCount, bool usePotStride)
@@ -70,7 +124,6 @@ namespace theoraplayer
 		if (this->info.TheoraDecoder != NULL)
 		{
 			th_decode_free(this->info.TheoraDecoder);
-			th_setup_free(this->info.TheoraSetup);
 			if (this->audioInterface != NULL)
 			{
 				vorbis_dsp_clear(&this->info.VorbisDSPState);
@@ -78,12 +131,36 @@ namespace theoraplayer
 			}
 			ogg_stream_clear(&this->info.TheoraStreamState);
 			th_comment_clear(&this->info.TheoraComment);
-			th_info_clear(&this->info.TheoraInfo);
 			ogg_stream_clear(&this->info.VorbisStreamState);
 			vorbis_comment_clear(&this->info.VorbisComment);
-			vorbis_info_clear(&this->info.VorbisInfo);
+			if (this->sharedHeaders == NULL)
+			{
+				th_setup_free(this->info.TheoraSetup);
+				th_info_clear(&this->info.TheoraInfo);
+				vorbis_info_clear(&this->info.VorbisInfo);
+			}
 			ogg_sync_clear(&this->info.OggSyncState);
 		}
+		if (this->preroll.TheoraDecoder != NULL)
+		{
+			th_decode_free(this->preroll.TheoraDecoder);
+			ogg_stream_clear(&this->preroll.TheoraStreamState);
+			ogg_sync_clear(&this->preroll.OggSyncState);
+		}
+		if (this->preroll.stream != NULL)
+		{
+			delete this->preroll.stream;
+		}
+		this->_releaseSharedHeaders();
+		foreach (VideoFrame*, it, this->preroll.frames)
+		{
+			delete (*it);
+		}
+		foreach (VideoFrame*, it, this->reverseFrames)
+		{
+			delete (*it);
+		}
+		this->_trimCheckpoints(0, 0);
 	}
 
 	void VideoClip_Theora::_load(DataSource* source)
@@ -92,19 +169,20 @@ namespace theoraplayer
 		log("-----");
 #endif
 		this->stream = source;
-		this->_readTheoraVorbisHeaders();
-		this->info.TheoraDecoder = th_decode_alloc(&this->info.TheoraInfo, this->info.TheoraSetup);
-		this->width = this->info.TheoraInfo.frame_width;
-		this->height = this->info.TheoraInfo.frame_height;
-		this->subFrameWidth = this->info.TheoraInfo.pic_width;
-		this->subFrameHeight = this->info.TheoraInfo.pic_height;
-		this->subFrameX = this->info.TheoraInfo.pic_x;
-		this->subFrameY = this->info.TheoraInfo.pic_y;
-		this->stride = this->width;
-		if (this->useStride)
+		// clips of the same asset share immutable header data, the audio flag is part of the key since Vorbis headers are only parsed with audio
+		std::string sharedHeadersKey = source->getAssetId();
+		if (sharedHeadersKey != "")
 		{
-			this->stride = potCeil(this->stride);
+			sharedHeadersKey += " " + str((int)source->getSize()) + (theoraplayer::manager->getAudioInterfaceFactory() != NULL ? " audio" : "");
+		}
+		// data sources that can't tell whether they read the same data as another one keep their own headers
+		if (sharedHeadersKey == "" || !this->_useSharedHeaders(sharedHeadersKey))
+		{
+			this->_readTheoraVorbisHeaders();
 		}
+		this->info.TheoraDecoder = th_decode_alloc(&this->info.TheoraInfo, this->info.TheoraSetup);
+		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_GET_PPLEVEL_MAX, &this->maxPostProcessingLevel, sizeof(this->maxPostProcessingLevel));
+		this->_updateOutputSize();
 		this->fps = this->info.TheoraInfo.fps_numerator / (float)this->info.TheoraInfo.fps_denominator;
 #ifdef _DEBUG
 		if (this->stride <= this->width)
@@ -127,7 +205,11 @@ namespace theoraplayer
 		int64_t seekPos = 0;
 		int result = 0;
 		ogg_int64_t granule = 0;
-		for (unsigned int i = 1; i <= 50; ++i)
+		if (this->sharedHeaders != NULL)
+		{
+			this->framesCount = this->sharedHeaders->framesCount;
+		}
+		for (unsigned int i = 1; i <= 50 && this->sharedHeaders == NULL; ++i)
 		{
 			ogg_sync_reset(&this->info.OggSyncState);
 			seekPos = (BUFFER_SIZE * i > streamSize ? 0 : streamSize - BUFFER_SIZE * i);
@@ -174,8 +256,13 @@ namespace theoraplayer
 			log("duration: " + strf(this->duration) + " seconds");
 #endif
 		}
-		// restore to beginning of stream.
+		// restore to beginning of stream, the streams drop the data pages buffered while reading the headers or they would be decoded twice
 		ogg_sync_reset(&this->info.OggSyncState);
+		ogg_stream_reset(&this->info.TheoraStreamState);
+		if (this->vorbisStreams > 0)
+		{
+			ogg_stream_reset(&this->info.VorbisStreamState);
+		}
 		this->stream->seek(0);
 		if (this->vorbisStreams > 0) // if there is no audio interface factory defined, even though the video clip might have audio, it will be ignored
 		{
@@ -191,6 +278,11 @@ namespace theoraplayer
 			}
 		}
 		this->frameDuration = 1.0f / this->getFps();
+		// shared after the Vorbis setup since it completes the codebooks the clips share
+		if (this->sharedHeaders == NULL && sharedHeadersKey != "")
+		{
+			this->_shareHeaders(sharedHeadersKey);
+		}
 #ifdef _DEBUG
 		log("-----");
 #endif
@@ -209,6 +301,8 @@ namespace theoraplayer
 		char* buffer = NULL;
 		int bytesRead = 0;
 		ogg_int64_t granule = 0;
+		// audio is silent during trick-play
+		bool decodeAudio = (this->audioInterface != NULL && !this->_isTrickPlaying());
 		do
 		{
 			buffer = ogg_sync_buffer(&this->info.OggSyncState, BUFFER_SIZE);
@@ -232,7 +326,7 @@ namespace theoraplayer
 				{
 					ogg_stream_pagein(&this->info.TheoraStreamState, &this->info.OggPage);
 				}
-				if (this->audioInterface != NULL && serno == this->info.VorbisStreamState.serialno)
+				if (decodeAudio && serno == this->info.VorbisStreamState.serialno)
 				{
 					granule = ogg_page_granulepos(&this->info.OggPage);
 					audioTime = (float)vorbis_granule_time(&this->info.VorbisDSPState, granule);
@@ -240,7 +334,7 @@ namespace theoraplayer
 					ogg_stream_pagein(&this->info.VorbisStreamState, &this->info.OggPage);
 				}
 			}
-		} while (this->audioInterface != NULL && audioEos == 0 && audioTime < time + 1.0f);
+		} while (decodeAudio && audioEos == 0 && audioTime < time + 1.0f);
 		return true;
 	}
 
@@ -255,10 +349,32 @@ namespace theoraplayer
 		{
 			return false; // max number of precached frames reached
 		}
+		if (this->trickPlayReverse)
+		{
+			return this->_decodeReverseFrame(frame);
+		}
+		if (this->_fetchLoopCachedFrame(frame) || this->_deliverPrerolledFrame(frame))
+		{
+			return true;
+		}
+		bool frameDecoded = false;
 		bool shouldRestart = false;
+		bool timestampsOnly = (this->visibility == VISIBILITY_TIMESTAMPS_ONLY);
+		bool dirtyTracking = (this->incrementalConversion && !this->useAlpha && this->width == (int)this->info.TheoraInfo.frame_width &&
+			this->height == (int)this->info.TheoraInfo.frame_height);
+		if (this->dirtyTracking != dirtyTracking)
+		{
+			this->dirtyTracking = dirtyTracking;
+			if (this->dirtyTracking)
+			{
+				int count = (this->info.TheoraInfo.frame_width >> 4) * (this->info.TheoraInfo.frame_height >> 4);
+				this->dirtyHistory.resize(DIRTY_HISTORY_SIZE * count);
+				this->dirtyMacroblocks.resize(count);
+			}
+			this->_resetDirtyMacroblocks();
+		}
 		ogg_packet opTheora;
 		ogg_int64_t granulePos;
-		th_ycbcr_buffer buff;
 		int result = 0;
 		int attempts = 0;
 		int status = 0;
@@ -274,43 +390,103 @@ namespace theoraplayer
 			}
 			if (result > 0)
 			{
+				if (this->trickPlayKeyFrames && th_packet_iskeyframe(&opTheora) == 0)
+				{
+					++this->skippedPacketsCount;
+					continue;
+				}
+				if (this->decoderPostProcessingLevel != this->postProcessingLevel)
+				{
+					int level = this->postProcessingLevel;
+					th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_PPLEVEL, &level, sizeof(level));
+					this->decoderPostProcessingLevel = level;
+					this->_resetDirtyMacroblocks(); // post-processing changes the whole picture
+				}
 				status = th_decode_packetin(this->info.TheoraDecoder, &opTheora, &granulePos);
 				if (status != 0 && status != TH_DUPFRAME) // 0 means success
 				{
 					continue;
 				}
+				if (this->dirtyTracking && status == 0)
+				{
+					this->_trackDirtyMacroblocks();
+				}
+				if (this->skippedPacketsCount > 0)
+				{
+					// the decoder only counted the packets it got, so the key frame is further ahead than it thinks
+					granulePos = ((granulePos >> this->info.TheoraInfo.keyframe_granule_shift) + this->skippedPacketsCount) << this->info.TheoraInfo.keyframe_granule_shift;
+					ogg_int64_t nextGranulePos = granulePos + 1;
+					th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &nextGranulePos, sizeof(nextGranulePos));
+					this->skippedPacketsCount = 0;
+				}
 				time = (float)th_granule_time(this->info.TheoraDecoder, granulePos);
 				frameNumber = (unsigned long)th_granule_frame(this->info.TheoraDecoder, granulePos);
 				// %16 operation is here to prevent a playback halt during video playback if the decoder can't keep up with demand.
-				if (time < this->timer->getTime() && !this->restarted && frameNumber % 16 != 0)
+				if (time < this->timer->getTime() && !this->restarted && !this->trickPlayKeyFrames && frameNumber % 16 != 0)
 				{
 #ifdef _DEBUG_FRAMEDROP
 					log(mName + ": pre-dropped frame " + str((int)frameNumber));
 #endif
-					++this->droppedFramesCount;
+					if (!timestampsOnly)
+					{
+						++this->droppedFramesCount;
+					}
 					continue; // drop frame
 				}
 				this->_setVideoFrameTimeToDisplay(frame, time - this->frameDuration);
 				this->_setVideoFrameIteration(frame, this->iteration);
 				this->_setVideoFrameFrameNumber(frame, (int)frameNumber);
 				this->lastDecodedFrameNumber = frameNumber;
-				th_decode_ycbcr_out(this->info.TheoraDecoder, buff);
-				Theoraplayer_PixelTransform pixelTransform;
-				memset(&pixelTransform, 0, sizeof(Theoraplayer_PixelTransform));
-				pixelTransform.y = buff[0].data;	pixelTransform.yStride = buff[0].stride;
-				pixelTransform.u = buff[1].data;	pixelTransform.uStride = buff[1].stride;
-				pixelTransform.v = buff[2].data;	pixelTransform.vStride = buff[2].stride;
-				frame->decode(&pixelTransform);
+				if (timestampsOnly)
+				{
+					// the decoder state and the timing advance, but the picture is never shown
+					this->_setVideoFrameTimestampOnly(frame, true);
+					this->_setVideoFrameReady(frame, true);
+				}
+				else
+				{
+					if (this->dirtyTracking)
+					{
+						this->_decodeChangedMacroblocks(frame);
+					}
+					else
+					{
+						this->_decodeFrameBuffer(this->info.TheoraDecoder, frame);
+					}
+					this->_storeDecodedFrame(frame);
+				}
+				this->_saveCheckpoint((int)frameNumber);
+				frameDecoded = true;
 				break;
 			}
 			if (!this->_readData())
 			{
+				if (this->autoRestart && this->_startLoopCachePlayback())
+				{
+					// all frames are cached, the decoder stays idle until the next seek
+					this->_resetPreroll();
+					this->_fetchLoopCachedFrame(frame);
+					return true;
+				}
+				if (this->autoRestart && this->_continueFromPreroll())
+				{
+					// the next iteration is already decoded, so there's no need to wait for the decoder to restart
+					++this->iteration;
+					this->_deliverPrerolledFrame(frame);
+					return true;
+				}
 				this->_setVideoFrameInUse(frame, false);
 				shouldRestart = this->autoRestart;
 				break;
 			}
 		}
-		if (this->audioInterface != NULL)
+		if (frameDecoded && !timestampsOnly && this->autoRestart && this->prerollFramesCount > 0 && this->audioInterface == NULL &&
+			this->framesCount > 0 && (int)frameNumber + this->prerollFramesCount * 2 >= this->framesCount && !this->preroll.active)
+		{
+			// the frames of the next iteration are decoded by worker threads that have nothing else to decode
+			this->preroll.requested = true;
+		}
+		if (this->audioInterface != NULL && !this->_isTrickPlaying())
 		{
 			Mutex::ScopeLock lock(this->audioMutex);
 			this->_decodeAudio();
@@ -419,10 +595,14 @@ namespace theoraplayer
 
 	void VideoClip_Theora::_executeSeek()
 	{
+#ifdef _SEEK_BENCHMARK
+		clock_t benchmarkTime = clock();
+#endif
 #if _DEBUG
 		log(this->name + " [seek]: seeking to frame " + str(this->seekFrame));
 #endif
-		int frame = 0;
+		this->_applyTrickPlayMode();
+		this->_resetDirtyMacroblocks();
 		float time = this->seekFrame / getFps();
 		this->timer->seek(time);
 		bool paused = this->timer->isPaused();
@@ -433,10 +613,8 @@ namespace theoraplayer
 		this->endOfFile = false;
 		this->restarted = false;
 		this->_resetFrameQueue();
-		// reset the video decoder.
-		ogg_stream_reset(&this->info.TheoraStreamState);
-		th_decode_free(this->info.TheoraDecoder);
-		this->info.TheoraDecoder = th_decode_alloc(&this->info.TheoraInfo, this->info.TheoraSetup);
+		this->_resetPreroll();
+		this->_stopLoopCachePlayback();
 		Mutex::ScopeLock audioMutexLock;
 		if (this->audioInterface != NULL)
 		{
@@ -445,70 +623,17 @@ namespace theoraplayer
 			vorbis_synthesis_restart(&this->info.VorbisDSPState);
 			this->destroyAllAudioPackets();
 		}
-		// first seek to desired frame, then figure out the location of the
-		// previous key frame and seek to it.
-		// then by setting the correct time, the decoder will skip N frames untill
-		// we get the frame we want.
-		frame = (int)this->_seekPage(this->seekFrame, 1); // find the key frame nearest to the target frame
-#ifdef _DEBUG
-	//		log(mName + " [seek]: nearest key frame for frame " + str(mSeekFrame) + " is frame: " + str(frame));
-#endif
-		this->_seekPage(std::max(0, frame - 1), 0);
-
-		ogg_packet opTheora;
-		ogg_int64_t granulePos;
-		bool granuleSet = false;
-		if (frame <= 1)
+		if (this->trickPlayReverse)
 		{
-			if (this->info.TheoraInfo.version_major == 3 && this->info.TheoraInfo.version_minor == 2 && this->info.TheoraInfo.version_subminor == 0)
-			{
-				granulePos = 0;
-			}
-			else
-			{
-				granulePos = 1; // because of difference in granule interpretation in theora streams 3.2.0 and newer ones
-			}
-			th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &granulePos, sizeof(granulePos));
-			granuleSet = true;
+			// the frames before the target are decoded when the frame queue asks for them
+			this->reverseFrame = (this->framesCount > 0 ? std::min(this->seekFrame, this->framesCount - 1) : this->seekFrame);
+			this->reverseFramesCount = 0;
 		}
-		// now that we've found the key frame that preceeds our desired frame, lets keep on decoding frames until we
-		// reach our target frame.
-		int status = 0;
-		while (this->seekFrame != 0)
+		else if (!this->_seekDecoder(this->seekFrame))
 		{
-			if (ogg_stream_packetout(&this->info.TheoraStreamState, &opTheora) > 0)
-			{
-				if (!granuleSet)
-				{
-					// theora decoder requires to set the granule pos after seek to be able to determine the current frame
-					if (opTheora.granulepos < 0)
-					{
-						continue; // ignore prev delta frames until we hit a key frame
-					}
-					th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &opTheora.granulepos, sizeof(opTheora.granulepos));
-					granuleSet = true;
-				}
-				status = th_decode_packetin(this->info.TheoraDecoder, &opTheora, &granulePos);
-				if (status != 0 && status != TH_DUPFRAME)
-				{
-					continue;
-				}
-				frame = (int)th_granule_frame(this->info.TheoraDecoder, granulePos);
-				if (frame >= this->seekFrame - 1)
-				{
-					break;
-				}
-			}
-			else if (!this->_readData())
-			{
-				log(this->name + " [seek]: fineseeking failed, _readData failed!");
-				return;
-			}
+			return;
 		}
-#ifdef _DEBUG
-		//	log(mName + " [seek]: fineseeked to frame " + str(frame + 1) + ", requested: " + str(mSeekFrame));
-#endif
-		if (this->audioInterface != NULL)
+		if (this->audioInterface != NULL && !this->_isTrickPlaying())
 		{
 			// read audio data until we reach a timeStamp. this usually takes only one iteration, but just in case let's
 			// wrap it in a loop
@@ -581,21 +706,28 @@ namespace theoraplayer
 		{
 			this->timer->play();
 		}
+#ifdef _SEEK_BENCHMARK
+		log("BENCHMARK: " + this->name + ": seeking to frame " + str(this->seekFrame) + " took " + strf(((float)(clock() - benchmarkTime) * 1000.0f) / CLOCKS_PER_SEC) + "ms");
+#endif
 		this->seekFrame = -1;
 	}
 
 	void VideoClip_Theora::_executeRestart()
 	{
+#ifdef _SEEK_BENCHMARK
+		clock_t benchmarkTime = clock();
+#endif
 		bool paused = this->timer->isPaused();
 		if (!paused)
 		{
 			this->timer->pause();
 		}
-		long initialGranule = 0;
-		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &initialGranule, sizeof(initialGranule));
-		th_decode_free(this->info.TheoraDecoder);
-		this->info.TheoraDecoder = th_decode_alloc(&this->info.TheoraInfo, this->info.TheoraSetup);
+		this->_resetPreroll();
+		this->_stopLoopCachePlayback();
+		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_RESET, NULL, 0);
+		this->_resetDirtyMacroblocks();
 		ogg_stream_reset(&this->info.TheoraStreamState);
+		this->skippedPacketsCount = 0;
 		if (this->audioInterface != NULL)
 		{
 			// empty the DSP buffer
@@ -612,135 +744,925 @@ namespace theoraplayer
 		}
 		ogg_sync_reset(&this->info.OggSyncState);
 		this->stream->seek(0);
-		ogg_int64_t granulePos = 0;
-		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &granulePos, sizeof(granulePos));
+		this->_setInitialGranulePos(this->info.TheoraDecoder);
 		this->endOfFile = false;
 		this->restarted = true;
 		if (!paused)
 		{
 			this->timer->play();
 		}
+#ifdef _SEEK_BENCHMARK
+		log("BENCHMARK: " + this->name + ": restarting took " + strf(((float)(clock() - benchmarkTime) * 1000.0f) / CLOCKS_PER_SEC) + "ms");
+#endif
 	}
 
-	long VideoClip_Theora::_seekPage(long targetFrame, bool returnKeyFrame)
+	void VideoClip_Theora::_executeScrub()
 	{
-		int64_t seekMin = 0;
-		int64_t seekMax = this->stream->getSize();
-		long frame = 0;
-		ogg_int64_t granule = 0;
-		if (targetFrame == 0)
+#ifdef _SEEK_BENCHMARK
+		clock_t benchmarkTime = clock();
+#endif
+		int frame = this->scrubFrame;
+		this->scrubFrame = -1;
+		this->endOfFile = false;
+		this->restarted = false;
+		this->_applyTrickPlayMode();
+		this->_resetFrameQueue();
+		this->_resetPreroll();
+		this->_stopLoopCachePlayback();
+		this->_resetDirtyMacroblocks();
+		if (this->audioInterface != NULL)
 		{
-			this->stream->seek(0);
+			// audio stays silent until the target is refined by a regular seek
+			Mutex::ScopeLock audioMutexLock(this->audioMutex);
+			ogg_stream_reset(&this->info.VorbisStreamState);
+			vorbis_synthesis_restart(&this->info.VorbisDSPState);
+			this->destroyAllAudioPackets();
 		}
-		char* buffer = NULL;
-		int bytesRead = 0;
-		if (targetFrame != 0)
+		// only the key frame before the target is decoded, the frames between it and the target are skipped
+		long keyFrame = this->_seekKeyFrame(frame);
+		if (keyFrame >= 0)
 		{
-			for (int i = 0; i < 100; ++i)
-			{
-				ogg_sync_reset(&this->info.OggSyncState);
-				this->stream->seek(seekMin / 2 + seekMax / 2); // do a binary search
-				memset(&this->info.OggPage, 0, sizeof(ogg_page));
-				ogg_sync_pageseek(&this->info.OggSyncState, &this->info.OggPage);
-				while (i < 1000)
-				{
-					if (ogg_sync_pageout(&this->info.OggSyncState, &this->info.OggPage) == 1)
-					{
-						if (ogg_page_serialno(&this->info.OggPage) == this->info.TheoraStreamState.serialno)
-						{
-							granule = ogg_page_granulepos(&this->info.OggPage);
-							if (granule >= 0)
-							{
-								frame = (long)th_granule_frame(this->info.TheoraDecoder, granule);
-								if (frame < targetFrame && targetFrame - frame < 10)
-								{
-									// we're close enough, let's break this.
-									i = 1000;
-									break;
-								}
-								// we're not close enough, let's shorten the borders of the binary search
-								if (targetFrame - 1 > frame)
-								{
-									seekMin = seekMin / 2 + seekMax / 2;
-								}
-								else
-								{
-									seekMax = seekMin / 2 + seekMax / 2;
-								}
-								break;
-							}
-						}
-					}
-					else
-					{
-						buffer = ogg_sync_buffer(&this->info.OggSyncState, BUFFER_SIZE);
-						bytesRead = this->stream->read(buffer, BUFFER_SIZE);
-						if (bytesRead == 0)
-						{
-							break;
-						}
-						ogg_sync_wrote(&this->info.OggSyncState, bytesRead);
-					}
-				}
-			}
+			this->timer->seek(keyFrame * this->frameDuration);
 		}
-		if (returnKeyFrame)
+		else
 		{
-			return (long)(granule >> this->info.TheoraInfo.keyframe_granule_shift);
+			this->seekFrame = frame;
+			this->_executeSeek();
 		}
-		ogg_sync_reset(&this->info.OggSyncState);
-		memset(&this->info.OggPage, 0, sizeof(ogg_page));
-		ogg_sync_pageseek(&this->info.OggSyncState, &this->info.OggPage);
-		if (targetFrame == 0)
+		this->_decodeNextFrame();
+#ifdef _SEEK_BENCHMARK
+		log("BENCHMARK: " + this->name + ": scrubbing to frame " + str(frame) + " (key frame " + str((int)keyFrame) + ") took " + strf(((float)(clock() - benchmarkTime) * 1000.0f) / CLOCKS_PER_SEC) + "ms");
+#endif
+	}
+
+	void VideoClip_Theora::_setInitialGranulePos(th_dec_ctx* decoder)
+	{
+		ogg_int64_t granulePos = 1; // because of difference in granule interpretation in theora streams 3.2.0 and newer ones
+		if (this->info.TheoraInfo.version_major == 3 && this->info.TheoraInfo.version_minor == 2 && this->info.TheoraInfo.version_subminor == 0)
 		{
-			return -1;
+			granulePos = 0;
 		}
-		this->stream->seek((seekMin + seekMax) / 2); // do a binary search
-		return -1;
+		th_decode_ctl(decoder, TH_DECCTL_SET_GRANPOS, &granulePos, sizeof(granulePos));
 	}
 
-	void VideoClip_Theora::_readTheoraVorbisHeaders()
+	void VideoClip_Theora::_updateOutputSize()
 	{
-		// init Vorbis/Theora Layer
-		ogg_packet tempOggPacket;
-		// ensure all structures get cleared out
-		memset(&this->info.OggSyncState, 0, sizeof(ogg_sync_state));
-		memset(&this->info.OggPage, 0, sizeof(ogg_page));
-		memset(&this->info.VorbisStreamState, 0, sizeof(ogg_stream_state));
-		memset(&this->info.TheoraStreamState, 0, sizeof(ogg_stream_state));
-		memset(&this->info.TheoraInfo, 0, sizeof(th_info));
-		memset(&this->info.TheoraComment, 0, sizeof(th_comment));
-		memset(&this->info.VorbisInfo, 0, sizeof(vorbis_info));
-		memset(&this->info.VorbisDSPState, 0, sizeof(vorbis_dsp_state));
-		memset(&this->info.VorbisBlock, 0, sizeof(vorbis_block));
-		memset(&this->info.VorbisComment, 0, sizeof(vorbis_comment));
-		// init all structures
-		ogg_sync_init(&this->info.OggSyncState);
-		th_comment_init(&this->info.TheoraComment);
-		th_info_init(&this->info.TheoraInfo);
-		vorbis_info_init(&this->info.VorbisInfo);
-		vorbis_comment_init(&this->info.VorbisComment);
-		// start
-		ogg_stream_state oggStateTest;
-		bool decodeAudio = (theoraplayer::manager->getAudioInterfaceFactory() != NULL);
-		char* buffer = NULL;
-		int bytesRead = 0;
-		bool done = false;
-		while (!done)
+		int frameWidth = this->info.TheoraInfo.frame_width;
+		int frameHeight = this->info.TheoraInfo.frame_height;
+		this->cropX = 0;
+		this->cropY = 0;
+		this->cropWidth = frameWidth;
+		this->cropHeight = frameHeight;
+		this->subFrameWidth = this->info.TheoraInfo.pic_width;
+		this->subFrameHeight = this->info.TheoraInfo.pic_height;
+		this->subFrameX = this->info.TheoraInfo.pic_x;
+		this->subFrameY = this->info.TheoraInfo.pic_y;
+		if (this->outputCropping)
 		{
-			buffer = ogg_sync_buffer(&this->info.OggSyncState, BUFFER_SIZE);
-			bytesRead = this->stream->read(buffer, BUFFER_SIZE);
-			ogg_sync_wrote(&this->info.OggSyncState, bytesRead);
-			if (bytesRead == 0)
+			// the crop starts and ends on even pixels so every pair of pixels shares its chroma sample like in the whole frame
+			this->cropY = this->subFrameY & ~1;
+			this->cropHeight = ((this->subFrameY + this->subFrameHeight + 1) & ~1) - this->cropY;
+			// the picture and the alpha channel are side by side in the frame, they would need to be cropped separately
+			if (!this->useAlpha)
 			{
-				break;
+				this->cropX = this->subFrameX & ~1;
+				this->cropWidth = ((this->subFrameX + this->subFrameWidth + 1) & ~1) - this->cropX;
 			}
-			while (ogg_sync_pageout(&this->info.OggSyncState, &this->info.OggPage) > 0)
-			{
-				memset(&oggStateTest, 0, sizeof(oggStateTest));
-				//is this an initial header? If not, stop
-				if (ogg_page_bos(&this->info.OggPage) == 0)
-				{
+			this->subFrameX -= this->cropX;
+			this->subFrameY -= this->cropY;
+			frameWidth = this->cropWidth;
+			frameHeight = this->cropHeight;
+		}
+		this->width = frameWidth;
+		this->height = frameHeight;
+		if (this->outputScale < 1.0f)
+		{
+			// the converters work on pairs of pixels, so both halves of clips with an alpha channel have to stay even
+			this->width = std::max((int)(frameWidth * this->outputScale / 4.0f + 0.5f), 1) * 4;
+			this->height = std::max((int)(frameHeight * this->outputScale / 2.0f + 0.5f), 1) * 2;
+			this->subFrameWidth = this->subFrameWidth * this->width / frameWidth;
+			this->subFrameHeight = this->subFrameHeight * this->height / frameHeight;
+			this->subFrameX = this->subFrameX * this->width / frameWidth;
+			this->subFrameY = this->subFrameY * this->height / frameHeight;
+		}
+		this->stride = this->width;
+		if (this->useStride)
+		{
+			this->stride = potCeil(this->stride);
+		}
+		// frames decoded ahead of time have the old size
+		this->preroll.outputMode = FORMAT_UNDEFINED;
+		this->reverseOutputMode = FORMAT_UNDEFINED;
+	}
+
+	void VideoClip_Theora::_decodeFrameBuffer(th_dec_ctx* decoder, VideoFrame* frame)
+	{
+		th_ycbcr_buffer buff;
+		th_decode_ycbcr_out(decoder, buff);
+		if (this->cropWidth != buff[0].width || this->cropHeight != buff[0].height)
+		{
+			this->_cropFrameBuffer(buff);
+		}
+		if (this->width != buff[0].width || this->height != buff[0].height)
+		{
+			this->_scaleFrameBuffer(buff);
+		}
+		Theoraplayer_PixelTransform pixelTransform;
+		_setPixelTransformPlanes(&pixelTransform, buff);
+		frame->decode(&pixelTransform);
+	}
+
+	void VideoClip_Theora::_cropFrameBuffer(th_ycbcr_buffer buffer)
+	{
+		int frameWidth = buffer[0].width;
+		int frameHeight = buffer[0].height;
+		for (int i = 0; i < 3; ++i)
+		{
+			// chroma planes are subsampled by the ratio of their size to the luma plane
+			buffer[i].data += this->cropY * buffer[i].height / frameHeight * buffer[i].stride + this->cropX * buffer[i].width / frameWidth;
+			buffer[i].width = this->cropWidth * buffer[i].width / frameWidth;
+			buffer[i].height = this->cropHeight * buffer[i].height / frameHeight;
+		}
+	}
+
+	void VideoClip_Theora::_scaleFrameBuffer(th_ycbcr_buffer buffer)
+	{
+		int width = this->width;
+		int height = this->height;
+		// the chroma planes are scaled to half the size, so sources with any chroma subsampling come out as 4:2:0
+		this->scaledPlanes.resize(width * height + (width / 2) * (height / 2) * 2);
+		unsigned char* output = &this->scaledPlanes[0];
+		// the picture and the alpha channel are side by side, each half is scaled on its own so they don't bleed into each other
+		int halves = (this->useAlpha ? 2 : 1);
+		int filter = (this->scaleFilter == SCALE_FILTER_BOX ? 0 : 1);
+		for (int i = 0; i < 3; ++i)
+		{
+			int sourceWidth = buffer[i].width / halves;
+			int scaledWidth = (i == 0 ? width : width / 2);
+			int scaledHeight = (i == 0 ? height : height / 2);
+			for (int j = 0; j < halves; ++j)
+			{
+				scalePlane(buffer[i].data + j * sourceWidth, buffer[i].stride, sourceWidth, buffer[i].height,
+					output + j * scaledWidth / halves, scaledWidth, scaledWidth / halves, scaledHeight, filter);
+			}
+			buffer[i].data = output;
+			buffer[i].stride = scaledWidth;
+			buffer[i].width = scaledWidth;
+			buffer[i].height = scaledHeight;
+			output += scaledWidth * scaledHeight;
+		}
+	}
+
+	void VideoClip_Theora::_decodeChangedMacroblocks(VideoFrame* frame)
+	{
+		unsigned char* macroblocks = &this->dirtyMacroblocks[0];
+		// consumers that showed the previous frame only have to update what changed since then
+		bool known = this->_accumulateDirtyMacroblocks(this->queuedPictureSerial, macroblocks);
+		this->_setVideoFrameDirtyMacroblocks(frame, known ? macroblocks : NULL);
+		int frameSerial = this->_getVideoFramePictureSerial(frame);
+		// the frame buffer usually holds an older picture than the previous frame, so more may have changed since then
+		if (frameSerial != this->queuedPictureSerial)
+		{
+			known = this->_accumulateDirtyMacroblocks(frameSerial, macroblocks);
+		}
+		if (known)
+		{
+			th_ycbcr_buffer buff;
+			th_decode_ycbcr_out(this->info.TheoraDecoder, buff);
+			Theoraplayer_PixelTransform pixelTransform;
+			_setPixelTransformPlanes(&pixelTransform, buff);
+			frame->decodeMacroblocks(&pixelTransform, macroblocks);
+		}
+		else
+		{
+			this->_decodeFrameBuffer(this->info.TheoraDecoder, frame);
+		}
+		this->_setVideoFramePictureSerial(frame, this->pictureSerial);
+		this->queuedPictureSerial = this->pictureSerial;
+	}
+
+	void VideoClip_Theora::_trackDirtyMacroblocks()
+	{
+		int countX = this->info.TheoraInfo.frame_width >> 4;
+		int countY = this->info.TheoraInfo.frame_height >> 4;
+		int count = countX * countY;
+		unsigned char* coded = &this->dirtyMacroblocks[0];
+		++this->pictureSerial;
+		unsigned char* changed = &this->dirtyHistory[(this->pictureSerial % DIRTY_HISTORY_SIZE) * count];
+		if (th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_GET_CODED_MBS, coded, count) != 0)
+		{
+			memset(changed, 1, count);
+			return;
+		}
+		// the loop filter and post-processing also change the pixels next to coded macroblocks
+		int x = 0;
+		int y = 0;
+		for (int j = 0; j < countY; ++j)
+		{
+			for (int i = 0; i < countX; ++i)
+			{
+				unsigned char value = 0;
+				for (y = std::max(j - 1, 0); y <= std::min(j + 1, countY - 1) && value == 0; ++y)
+				{
+					for (x = std::max(i - 1, 0); x <= std::min(i + 1, countX - 1) && value == 0; ++x)
+					{
+						value = coded[y * countX + x];
+					}
+				}
+				changed[j * countX + i] = value;
+			}
+		}
+	}
+
+	bool VideoClip_Theora::_accumulateDirtyMacroblocks(int pictureSerial, unsigned char* macroblocks)
+	{
+		if (pictureSerial < this->dirtyBaseSerial || this->pictureSerial - pictureSerial > DIRTY_HISTORY_SIZE)
+		{
+			return false;
+		}
+		int count = (int)this->dirtyMacroblocks.size();
+		memset(macroblocks, 0, count);
+		const unsigned char* changed = NULL;
+		for (int serial = pictureSerial + 1; serial <= this->pictureSerial; ++serial)
+		{
+			changed = &this->dirtyHistory[(serial % DIRTY_HISTORY_SIZE) * count];
+			for (int i = 0; i < count; ++i)
+			{
+				macroblocks[i] |= changed[i];
+			}
+		}
+		return true;
+	}
+
+	void VideoClip_Theora::_resetDirtyMacroblocks()
+	{
+		this->dirtyBaseSerial = this->pictureSerial + 1;
+	}
+
+	bool VideoClip_Theora::_startPreroll()
+	{
+		if (this->preroll.stream == NULL)
+		{
+			this->preroll.stream = this->stream->clone();
+			if (this->preroll.stream == NULL)
+			{
+				// active without frames, so it isn't requested again before the clip restarts the regular way
+				this->preroll.requested = false;
+				this->preroll.active = true;
+				this->preroll.decodedFramesCount = 0;
+				return false;
+			}
+		}
+		if (this->preroll.TheoraDecoder == NULL)
+		{
+			memset(&this->preroll.OggSyncState, 0, sizeof(ogg_sync_state));
+			memset(&this->preroll.OggPage, 0, sizeof(ogg_page));
+			memset(&this->preroll.TheoraStreamState, 0, sizeof(ogg_stream_state));
+			ogg_sync_init(&this->preroll.OggSyncState);
+			ogg_stream_init(&this->preroll.TheoraStreamState, this->info.TheoraStreamState.serialno);
+			this->preroll.TheoraDecoder = th_decode_alloc(&this->info.TheoraInfo, this->info.TheoraSetup);
+			this->preroll.decoderPostProcessingLevel = 0;
+		}
+		else
+		{
+			ogg_sync_reset(&this->preroll.OggSyncState);
+			ogg_stream_reset(&this->preroll.TheoraStreamState);
+			th_decode_ctl(this->preroll.TheoraDecoder, TH_DECCTL_RESET, NULL, 0);
+		}
+		this->_setInitialGranulePos(this->preroll.TheoraDecoder);
+		this->preroll.stream->seek(0);
+		if ((int)this->preroll.frames.size() != this->prerollFramesCount || this->preroll.outputMode != this->outputMode)
+		{
+			foreach (VideoFrame*, it, this->preroll.frames)
+			{
+				delete (*it);
+			}
+			this->preroll.frames.clear();
+			for (int i = 0; i < this->prerollFramesCount; ++i)
+			{
+				this->preroll.frames.push_back(new VideoFrame(this));
+			}
+			this->preroll.outputMode = this->outputMode;
+		}
+		this->preroll.decodedFramesCount = 0;
+		this->preroll.active = true;
+		return true;
+	}
+
+	bool VideoClip_Theora::_readPrerollData()
+	{
+		char* buffer = ogg_sync_buffer(&this->preroll.OggSyncState, BUFFER_SIZE);
+		int bytesRead = this->preroll.stream->read(buffer, BUFFER_SIZE);
+		ogg_sync_wrote(&this->preroll.OggSyncState, bytesRead);
+		if (bytesRead == 0)
+		{
+			return false;
+		}
+		while (ogg_sync_pageout(&this->preroll.OggSyncState, &this->preroll.OggPage) > 0)
+		{
+			if (ogg_page_serialno(&this->preroll.OggPage) == this->preroll.TheoraStreamState.serialno)
+			{
+				ogg_stream_pagein(&this->preroll.TheoraStreamState, &this->preroll.OggPage);
+			}
+		}
+		return true;
+	}
+
+	bool VideoClip_Theora::_isPrerollPending() const
+	{
+		return this->preroll.requested;
+	}
+
+	void VideoClip_Theora::_prerollNextFrame()
+	{
+		if (!this->preroll.requested)
+		{
+			return; // the pre-roll was reset after it was assigned to the worker thread
+		}
+		if (!this->preroll.active && !this->_startPreroll())
+		{
+			return;
+		}
+		if (this->preroll.decodedFramesCount >= (int)this->preroll.frames.size())
+		{
+			this->preroll.requested = false;
+			return;
+		}
+		ogg_packet opTheora;
+		ogg_int64_t granulePos;
+		int result = 0;
+		int status = 0;
+		VideoFrame* frame = NULL;
+		while (true)
+		{
+			result = ogg_stream_packetout(&this->preroll.TheoraStreamState, &opTheora);
+			if (result > 0)
+			{
+				if (this->preroll.decoderPostProcessingLevel != this->postProcessingLevel)
+				{
+					int level = this->postProcessingLevel;
+					th_decode_ctl(this->preroll.TheoraDecoder, TH_DECCTL_SET_PPLEVEL, &level, sizeof(level));
+					this->preroll.decoderPostProcessingLevel = level;
+				}
+				// header packets at the start of the stream are rejected here as well
+				status = th_decode_packetin(this->preroll.TheoraDecoder, &opTheora, &granulePos);
+				if (status != 0 && status != TH_DUPFRAME)
+				{
+					continue;
+				}
+				frame = this->preroll.frames[this->preroll.decodedFramesCount];
+				this->_setVideoFrameTimeToDisplay(frame, (float)th_granule_time(this->preroll.TheoraDecoder, granulePos) - this->frameDuration);
+				this->_setVideoFrameFrameNumber(frame, (int)th_granule_frame(this->preroll.TheoraDecoder, granulePos));
+				this->_decodeFrameBuffer(this->preroll.TheoraDecoder, frame);
+				++this->preroll.decodedFramesCount;
+				if (this->preroll.decodedFramesCount >= (int)this->preroll.frames.size())
+				{
+					this->preroll.requested = false;
+				}
+				return;
+			}
+			if (result == 0 && !this->_readPrerollData())
+			{
+				this->preroll.requested = false; // the clip is shorter than the pre-roll
+				return;
+			}
+		}
+	}
+
+	bool VideoClip_Theora::_continueFromPreroll()
+	{
+		if (!this->preroll.active || this->preroll.decodedFramesCount == 0 || this->preroll.outputMode != this->outputMode)
+		{
+			this->_resetPreroll();
+			return false;
+		}
+		// the pre-roll cursor becomes the main cursor, the exhausted main cursor will be reset when the next pre-roll starts
+		std::swap(this->info.OggSyncState, this->preroll.OggSyncState);
+		std::swap(this->info.TheoraStreamState, this->preroll.TheoraStreamState);
+		std::swap(this->info.TheoraDecoder, this->preroll.TheoraDecoder);
+		std::swap(this->decoderPostProcessingLevel, this->preroll.decoderPostProcessingLevel);
+		this->_resetDirtyMacroblocks();
+		this->stream->seek(this->preroll.stream->getPosition());
+		this->preroll.requested = false;
+		this->preroll.active = false;
+		this->preroll.deliveredFramesCount = 0;
+		this->endOfFile = false;
+		this->restarted = true;
+		return true;
+	}
+
+	bool VideoClip_Theora::_deliverPrerolledFrame(VideoFrame* frame)
+	{
+		if (this->preroll.deliveredFramesCount < 0)
+		{
+			return false;
+		}
+		if (this->preroll.outputMode != this->outputMode)
+		{
+			// the output mode changed during the loop transition so the remaining pre-rolled frames can't be used
+			this->_executeRestart();
+			return false;
+		}
+		VideoFrame* prerolledFrame = this->preroll.frames[this->preroll.deliveredFramesCount];
+		this->_swapVideoFrameBuffers(frame, prerolledFrame);
+		this->_setVideoFrameTimeToDisplay(frame, prerolledFrame->getTimeToDisplay());
+		this->_setVideoFrameIteration(frame, this->iteration);
+		this->_setVideoFrameFrameNumber(frame, (int)prerolledFrame->getFrameNumber());
+		this->_setVideoFrameReady(frame, true);
+		this->_storeDecodedFrame(frame);
+		this->lastDecodedFrameNumber = prerolledFrame->getFrameNumber();
+		++this->preroll.deliveredFramesCount;
+		if (this->preroll.deliveredFramesCount >= this->preroll.decodedFramesCount)
+		{
+			this->_resetPreroll();
+		}
+		return true;
+	}
+
+	void VideoClip_Theora::_resetPreroll()
+	{
+		this->preroll.requested = false;
+		this->preroll.active = false;
+		this->preroll.decodedFramesCount = 0;
+		this->preroll.deliveredFramesCount = -1;
+	}
+
+	bool VideoClip_Theora::_decodeReverseFrame(VideoFrame* frame)
+	{
+		if (this->reverseFramesCount > 0 && this->reverseOutputMode != this->outputMode)
+		{
+			// the output mode changed, so the remaining frames have to be decoded again
+			this->reverseFrame = (int)this->reverseFrames[this->reverseFramesCount - 1]->getFrameNumber();
+			this->reverseFramesCount = 0;
+		}
+		while (this->reverseFramesCount == 0)
+		{
+			if (this->reverseFrame < 0)
+			{
+				this->_setVideoFrameInUse(frame, false);
+				this->endOfFile = true;
+				log(this->name + " finished playing");
+				return false;
+			}
+			this->_decodeReverseFrames();
+		}
+		--this->reverseFramesCount;
+		VideoFrame* reverseFrame = this->reverseFrames[this->reverseFramesCount];
+		this->_swapVideoFrameBuffers(frame, reverseFrame);
+		this->_setVideoFrameTimeToDisplay(frame, reverseFrame->getTimeToDisplay());
+		this->_setVideoFrameIteration(frame, this->iteration);
+		this->_setVideoFrameFrameNumber(frame, (int)reverseFrame->getFrameNumber());
+		this->_setVideoFrameReady(frame, true);
+		this->lastDecodedFrameNumber = reverseFrame->getFrameNumber();
+		return true;
+	}
+
+	void VideoClip_Theora::_decodeReverseFrames()
+	{
+		int lastFrame = this->reverseFrame;
+		int framesCount = (this->trickPlayKeyFrames ? 1 : this->reverseFramesBudget);
+		if (this->reverseOutputMode != this->outputMode)
+		{
+			foreach (VideoFrame*, it, this->reverseFrames)
+			{
+				delete (*it);
+			}
+			this->reverseFrames.clear();
+			this->reverseOutputMode = this->outputMode;
+		}
+		while ((int)this->reverseFrames.size() > framesCount)
+		{
+			delete this->reverseFrames.back();
+			this->reverseFrames.pop_back();
+		}
+		// a pass never starts before the key frame, so a group of pictures that fits into the budget is decoded only once
+		long keyFrame = this->_seekKeyFrame(lastFrame);
+		int firstFrame = std::max(lastFrame - framesCount + 1, 0);
+		if (keyFrame >= 0)
+		{
+			firstFrame = (this->trickPlayKeyFrames ? (int)keyFrame : std::max(firstFrame, (int)keyFrame));
+			if (this->trickPlayKeyFrames)
+			{
+				lastFrame = firstFrame;
+			}
+		}
+		if ((keyFrame < 0 || firstFrame != keyFrame) && !this->_seekDecoder(firstFrame))
+		{
+			this->reverseFrame = -1;
+			return;
+		}
+		if (this->decoderPostProcessingLevel != this->postProcessingLevel)
+		{
+			int level = this->postProcessingLevel;
+			th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_PPLEVEL, &level, sizeof(level));
+			this->decoderPostProcessingLevel = level;
+		}
+		ogg_packet opTheora;
+		ogg_int64_t granulePos;
+		int status = 0;
+		int frameNumber = 0;
+		VideoFrame* frame = NULL;
+		this->reverseFramesCount = 0;
+		while (this->reverseFramesCount < framesCount)
+		{
+			if (ogg_stream_packetout(&this->info.TheoraStreamState, &opTheora) > 0)
+			{
+				status = th_decode_packetin(this->info.TheoraDecoder, &opTheora, &granulePos);
+				if (status != 0 && status != TH_DUPFRAME)
+				{
+					continue;
+				}
+				frameNumber = (int)th_granule_frame(this->info.TheoraDecoder, granulePos);
+				if (this->reverseFramesCount == (int)this->reverseFrames.size())
+				{
+					this->reverseFrames.push_back(new VideoFrame(this));
+				}
+				frame = this->reverseFrames[this->reverseFramesCount];
+				this->_setVideoFrameTimeToDisplay(frame, (float)th_granule_time(this->info.TheoraDecoder, granulePos) - this->frameDuration);
+				this->_setVideoFrameFrameNumber(frame, frameNumber);
+				this->_decodeFrameBuffer(this->info.TheoraDecoder, frame);
+				++this->reverseFramesCount;
+				this->_saveCheckpoint(frameNumber);
+				if (frameNumber >= lastFrame)
+				{
+					break;
+				}
+			}
+			else if (!this->_readData())
+			{
+				this->endOfFile = false; // the end of the clip is reached at its first frame when playing backwards
+				break;
+			}
+		}
+		this->reverseFrame = firstFrame - 1;
+	}
+
+	void VideoClip_Theora::_saveCheckpoint(int frameNumber)
+	{
+		if (this->checkpointInterval == 0)
+		{
+			this->_trimCheckpoints(frameNumber, 0);
+			return;
+		}
+		if (frameNumber % this->checkpointInterval != 0 || this->checkpoints.find(frameNumber) != this->checkpoints.end())
+		{
+			return;
+		}
+		size_t size = 0;
+		if (th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_GET_SNAPSHOT_SIZE, &size, sizeof(size)) != 0 || (int64_t)size > this->checkpointMemoryLimit)
+		{
+			return;
+		}
+		this->_trimCheckpoints(frameNumber, this->checkpointMemoryLimit - size);
+		TheoraCheckpoint checkpoint;
+		checkpoint.data = new unsigned char[size];
+		checkpoint.size = size;
+		if (th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SAVE_SNAPSHOT, checkpoint.data, checkpoint.size) != 0)
+		{
+			delete[] checkpoint.data;
+			return;
+		}
+		this->checkpoints[frameNumber] = checkpoint;
+		this->checkpointsSize += size;
+	}
+
+	int VideoClip_Theora::_restoreCheckpoint(int keyFrame, int targetFrame)
+	{
+		// the checkpoint has to be before the target frame, because the target frame is decoded by _decodeNextFrame()
+		std::map<int, TheoraCheckpoint>::iterator it = this->checkpoints.upper_bound(targetFrame - 1);
+		if (it == this->checkpoints.begin())
+		{
+			return -1;
+		}
+		--it;
+		if (it->first < keyFrame)
+		{
+			return -1; // decoding from the key frame is faster
+		}
+		int checkpointFrame = it->first;
+		if (!this->_seekPacket(checkpointFrame + 1))
+		{
+			return -1;
+		}
+		// the packet is left in the stream, so it's the first one decoded after restoring the decoder state
+		if (th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_RESTORE_SNAPSHOT, it->second.data, it->second.size) != 0)
+		{
+			ogg_stream_reset(&this->info.TheoraStreamState);
+			if (this->audioInterface != NULL)
+			{
+				ogg_stream_reset(&this->info.VorbisStreamState);
+			}
+			return -1;
+		}
+		return checkpointFrame;
+	}
+
+	bool VideoClip_Theora::_seekPacket(long frame)
+	{
+		this->_seekPage(frame, 0);
+		ogg_packet opTheora;
+		// the frame numbers of packets without a granule position are counted from the last one that had one, except at the
+		// start of the stream where the first frame follows the headers
+		bool counting = (frame == 0);
+		long packetFrame = -1;
+		int result = 0;
+		while (true)
+		{
+			result = ogg_stream_packetpeek(&this->info.TheoraStreamState, &opTheora);
+			if (result < 0)
+			{
+				counting = false; // there's a gap in the data, so the frame numbers have to be found again
+				continue;
+			}
+			if (result == 0)
+			{
+				if (this->_readData())
+				{
+					continue;
+				}
+				break;
+			}
+			if (th_packet_isheader(&opTheora) == 0)
+			{
+				if (opTheora.granulepos >= 0)
+				{
+					packetFrame = (long)th_granule_frame(this->info.TheoraDecoder, opTheora.granulepos);
+					counting = true;
+				}
+				else if (counting)
+				{
+					++packetFrame;
+				}
+				if (counting && packetFrame == frame)
+				{
+					return true;
+				}
+				if (counting && packetFrame > frame)
+				{
+					break; // the page search went too far
+				}
+			}
+			ogg_stream_packetout(&this->info.TheoraStreamState, &opTheora);
+		}
+		this->endOfFile = false;
+		ogg_stream_reset(&this->info.TheoraStreamState);
+		if (this->audioInterface != NULL)
+		{
+			ogg_stream_reset(&this->info.VorbisStreamState);
+		}
+		return false;
+	}
+
+	long VideoClip_Theora::_seekKeyFrame(long frame)
+	{
+		ogg_stream_reset(&this->info.TheoraStreamState);
+		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_RESET, NULL, 0);
+		this->skippedPacketsCount = 0;
+		ogg_int64_t granule = (ogg_int64_t)this->_seekPage(frame, 1) << this->info.TheoraInfo.keyframe_granule_shift;
+		long keyFrame = std::max((long)th_granule_frame(this->info.TheoraDecoder, granule), 0L);
+		if (keyFrame > frame)
+		{
+			keyFrame = 0; // the page search didn't find anything before the frame
+		}
+		if (!this->_seekPacket(keyFrame))
+		{
+			return -1;
+		}
+		if (keyFrame == 0)
+		{
+			this->_setInitialGranulePos(this->info.TheoraDecoder);
+		}
+		else
+		{
+			th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &granule, sizeof(granule));
+		}
+		return keyFrame;
+	}
+
+	void VideoClip_Theora::_trimCheckpoints(int frameNumber, int64_t memoryLimit)
+	{
+		std::map<int, TheoraCheckpoint>::iterator it;
+		while (this->checkpointsSize > memoryLimit && this->checkpoints.size() > 0)
+		{
+			// the checkpoints close to the playback position are the most likely to be needed by the next seek
+			it = this->checkpoints.begin();
+			if (frameNumber - it->first < this->checkpoints.rbegin()->first - frameNumber)
+			{
+				it = --this->checkpoints.end();
+			}
+			this->checkpointsSize -= it->second.size;
+			delete[] it->second.data;
+			this->checkpoints.erase(it);
+		}
+	}
+
+	bool VideoClip_Theora::_seekDecoder(int targetFrame)
+	{
+		// reset the video decoder.
+		ogg_stream_reset(&this->info.TheoraStreamState);
+		th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_RESET, NULL, 0);
+		this->skippedPacketsCount = 0;
+		if (this->decoderPostProcessingLevel != 0)
+		{
+			// frames decoded while fine-seeking are never shown, so they don't need post-processing
+			this->decoderPostProcessingLevel = 0;
+			th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_PPLEVEL, &this->decoderPostProcessingLevel, sizeof(this->decoderPostProcessingLevel));
+		}
+		// first seek to desired frame, then figure out the location of the
+		// previous key frame and seek to it.
+		// then by setting the correct time, the decoder will skip N frames untill
+		// we get the frame we want.
+		int frame = (int)this->_seekPage(targetFrame, 1); // find the key frame nearest to the target frame
+#ifdef _DEBUG
+	//		log(mName + " [seek]: nearest key frame for frame " + str(mSeekFrame) + " is frame: " + str(frame));
+#endif
+		ogg_packet opTheora;
+		ogg_int64_t granulePos;
+		bool granuleSet = false;
+		// a checkpoint between the key frame and the target frame saves decoding the frames before it
+		int checkpointFrame = this->_restoreCheckpoint(frame, targetFrame);
+		if (checkpointFrame >= 0)
+		{
+			granuleSet = true; // the restored decoder already knows the granule position
+		}
+		else
+		{
+			this->_seekPage(std::max(0, frame - 1), 0);
+			if (frame <= 1)
+			{
+				this->_setInitialGranulePos(this->info.TheoraDecoder);
+				granuleSet = true;
+			}
+		}
+		// now that we've found the key frame that preceeds our desired frame, lets keep on decoding frames until we
+		// reach our target frame.
+		int status = 0;
+		// frames decoded before the key frame are garbage and must not end up in checkpoints
+		bool keyFrameDecoded = (checkpointFrame >= 0);
+		while (targetFrame != 0 && checkpointFrame < targetFrame - 1)
+		{
+			if (ogg_stream_packetout(&this->info.TheoraStreamState, &opTheora) > 0)
+			{
+				if (!granuleSet)
+				{
+					// theora decoder requires to set the granule pos after seek to be able to determine the current frame
+					if (opTheora.granulepos < 0)
+					{
+						continue; // ignore prev delta frames until we hit a key frame
+					}
+					th_decode_ctl(this->info.TheoraDecoder, TH_DECCTL_SET_GRANPOS, &opTheora.granulepos, sizeof(opTheora.granulepos));
+					granuleSet = true;
+				}
+				status = th_decode_packetin(this->info.TheoraDecoder, &opTheora, &granulePos);
+				if (status != 0 && status != TH_DUPFRAME)
+				{
+					continue;
+				}
+				frame = (int)th_granule_frame(this->info.TheoraDecoder, granulePos);
+				if (th_packet_iskeyframe(&opTheora) == 1)
+				{
+					keyFrameDecoded = true;
+				}
+				if (keyFrameDecoded)
+				{
+					this->_saveCheckpoint(frame);
+				}
+				if (frame >= targetFrame - 1)
+				{
+					break;
+				}
+			}
+			else if (!this->_readData())
+			{
+				log(this->name + " [seek]: fineseeking failed, _readData failed!");
+				return false;
+			}
+		}
+#ifdef _DEBUG
+		//	log(mName + " [seek]: fineseeked to frame " + str(frame + 1) + ", requested: " + str(mSeekFrame));
+#endif
+		return true;
+	}
+
+	long VideoClip_Theora::_seekPage(long targetFrame, bool returnKeyFrame)
+	{
+		int64_t seekMin = 0;
+		int64_t seekMax = this->stream->getSize();
+		long frame = 0;
+		ogg_int64_t granule = 0;
+		if (targetFrame == 0)
+		{
+			this->stream->seek(0);
+		}
+		char* buffer = NULL;
+		int bytesRead = 0;
+		if (targetFrame != 0)
+		{
+			for (int i = 0; i < 100; ++i)
+			{
+				ogg_sync_reset(&this->info.OggSyncState);
+				this->stream->seek(seekMin / 2 + seekMax / 2); // do a binary search
+				memset(&this->info.OggPage, 0, sizeof(ogg_page));
+				ogg_sync_pageseek(&this->info.OggSyncState, &this->info.OggPage);
+				while (i < 1000)
+				{
+					if (ogg_sync_pageout(&this->info.OggSyncState, &this->info.OggPage) == 1)
+					{
+						if (ogg_page_serialno(&this->info.OggPage) == this->info.TheoraStreamState.serialno)
+						{
+							granule = ogg_page_granulepos(&this->info.OggPage);
+							if (granule >= 0)
+							{
+								frame = (long)th_granule_frame(this->info.TheoraDecoder, granule);
+								if (frame < targetFrame && targetFrame - frame < 10)
+								{
+									// we're close enough, let's break this.
+									i = 1000;
+									break;
+								}
+								// we're not close enough, let's shorten the borders of the binary search
+								if (targetFrame - 1 > frame)
+								{
+									seekMin = seekMin / 2 + seekMax / 2;
+								}
+								else
+								{
+									seekMax = seekMin / 2 + seekMax / 2;
+								}
+								break;
+							}
+						}
+					}
+					else
+					{
+						buffer = ogg_sync_buffer(&this->info.OggSyncState, BUFFER_SIZE);
+						bytesRead = this->stream->read(buffer, BUFFER_SIZE);
+						if (bytesRead == 0)
+						{
+							break;
+						}
+						ogg_sync_wrote(&this->info.OggSyncState, bytesRead);
+					}
+				}
+			}
+		}
+		if (returnKeyFrame)
+		{
+			return (long)(granule >> this->info.TheoraInfo.keyframe_granule_shift);
+		}
+		ogg_sync_reset(&this->info.OggSyncState);
+		memset(&this->info.OggPage, 0, sizeof(ogg_page));
+		ogg_sync_pageseek(&this->info.OggSyncState, &this->info.OggPage);
+		if (targetFrame == 0)
+		{
+			return -1;
+		}
+		this->stream->seek((seekMin + seekMax) / 2); // do a binary search
+		return -1;
+	}
+
+	void VideoClip_Theora::_readTheoraVorbisHeaders()
+	{
+		// init Vorbis/Theora Layer
+		ogg_packet tempOggPacket;
+		// ensure all structures get cleared out
+		memset(&this->info.OggSyncState, 0, sizeof(ogg_sync_state));
+		memset(&this->info.OggPage, 0, sizeof(ogg_page));
+		memset(&this->info.VorbisStreamState, 0, sizeof(ogg_stream_state));
+		memset(&this->info.TheoraStreamState, 0, sizeof(ogg_stream_state));
+		memset(&this->info.TheoraInfo, 0, sizeof(th_info));
+		memset(&this->info.TheoraComment, 0, sizeof(th_comment));
+		memset(&this->info.VorbisInfo, 0, sizeof(vorbis_info));
+		memset(&this->info.VorbisDSPState, 0, sizeof(vorbis_dsp_state));
+		memset(&this->info.VorbisBlock, 0, sizeof(vorbis_block));
+		memset(&this->info.VorbisComment, 0, sizeof(vorbis_comment));
+		// init all structures
+		ogg_sync_init(&this->info.OggSyncState);
+		th_comment_init(&this->info.TheoraComment);
+		th_info_init(&this->info.TheoraInfo);
+		vorbis_info_init(&this->info.VorbisInfo);
+		vorbis_comment_init(&this->info.VorbisComment);
+		// start
+		ogg_stream_state oggStateTest;
+		bool decodeAudio = (theoraplayer::manager->getAudioInterfaceFactory() != NULL);
+		char* buffer = NULL;
+		int bytesRead = 0;
+		bool done = false;
+		while (!done)
+		{
+			buffer = ogg_sync_buffer(&this->info.OggSyncState, BUFFER_SIZE);
+			bytesRead = this->stream->read(buffer, BUFFER_SIZE);
+			ogg_sync_wrote(&this->info.OggSyncState, bytesRead);
+			if (bytesRead == 0)
+			{
+				break;
+			}
+			while (ogg_sync_pageout(&this->info.OggSyncState, &this->info.OggPage) > 0)
+			{
+				memset(&oggStateTest, 0, sizeof(oggStateTest));
+				//is this an initial header? If not, stop
+				if (ogg_page_bos(&this->info.OggPage) == 0)
+				{
 					//This is done blindly, because stream only accept themselves
 					if (this->theoraStreams > 0)
 					{
@@ -829,5 +1751,81 @@ namespace theoraplayer
 		} // end while looking for all headers
 	}
 
+	bool VideoClip_Theora::_useSharedHeaders(const std::string& key)
+	{
+		Mutex::ScopeLock lock(&sharedHeadersMutex);
+		std::map<std::string, TheoraSharedHeaders*>::iterator it = sharedHeadersCache.find(key);
+		if (it == sharedHeadersCache.end())
+		{
+			return false;
+		}
+		this->sharedHeaders = it->second;
+		++this->sharedHeaders->referencesCount;
+		lock.release();
+		memset(&this->info.OggSyncState, 0, sizeof(ogg_sync_state));
+		memset(&this->info.OggPage, 0, sizeof(ogg_page));
+		memset(&this->info.VorbisStreamState, 0, sizeof(ogg_stream_state));
+		memset(&this->info.TheoraStreamState, 0, sizeof(ogg_stream_state));
+		memset(&this->info.TheoraComment, 0, sizeof(th_comment));
+		memset(&this->info.VorbisInfo, 0, sizeof(vorbis_info));
+		memset(&this->info.VorbisDSPState, 0, sizeof(vorbis_dsp_state));
+		memset(&this->info.VorbisBlock, 0, sizeof(vorbis_block));
+		memset(&this->info.VorbisComment, 0, sizeof(vorbis_comment));
+		ogg_sync_init(&this->info.OggSyncState);
+		th_comment_init(&this->info.TheoraComment);
+		vorbis_comment_init(&this->info.VorbisComment);
+		// the setup data is only read by th_decode_alloc() and the codebooks only by the Vorbis decoder, so the pointers can be shared
+		this->info.TheoraInfo = this->sharedHeaders->TheoraInfo;
+		this->info.TheoraSetup = this->sharedHeaders->TheoraSetup;
+		ogg_stream_init(&this->info.TheoraStreamState, this->sharedHeaders->theoraSerialNumber);
+		this->theoraStreams = 3;
+		if (this->sharedHeaders->vorbisSerialNumber != -1)
+		{
+			this->info.VorbisInfo = this->sharedHeaders->VorbisInfo;
+			ogg_stream_init(&this->info.VorbisStreamState, this->sharedHeaders->vorbisSerialNumber);
+			this->vorbisStreams = 3;
+		}
+		return true;
+	}
+
+	void VideoClip_Theora::_shareHeaders(const std::string& key)
+	{
+		Mutex::ScopeLock lock(&sharedHeadersMutex);
+		if (sharedHeadersCache.find(key) != sharedHeadersCache.end())
+		{
+			return; // another clip of this asset was loaded at the same time, this one keeps its own headers
+		}
+		TheoraSharedHeaders* headers = new TheoraSharedHeaders();
+		headers->key = key;
+		headers->referencesCount = 1;
+		headers->TheoraInfo = this->info.TheoraInfo;
+		headers->TheoraSetup = this->info.TheoraSetup;
+		headers->VorbisInfo = this->info.VorbisInfo;
+		headers->theoraSerialNumber = this->info.TheoraStreamState.serialno;
+		headers->vorbisSerialNumber = (this->vorbisStreams > 0 ? this->info.VorbisStreamState.serialno : -1);
+		headers->framesCount = this->framesCount;
+		sharedHeadersCache[key] = headers;
+		this->sharedHeaders = headers;
+	}
+
+	void VideoClip_Theora::_releaseSharedHeaders()
+	{
+		if (this->sharedHeaders == NULL)
+		{
+			return;
+		}
+		Mutex::ScopeLock lock(&sharedHeadersMutex);
+		--this->sharedHeaders->referencesCount;
+		if (this->sharedHeaders->referencesCount == 0)
+		{
+			sharedHeadersCache.erase(this->sharedHeaders->key);
+			th_setup_free(this->sharedHeaders->TheoraSetup);
+			th_info_clear(&this->sharedHeaders->TheoraInfo);
+			vorbis_info_clear(&this->sharedHeaders->VorbisInfo);
+			delete this->sharedHeaders;
+		}
+		this->sharedHeaders = NULL;
+	}
+
 }
 #endif
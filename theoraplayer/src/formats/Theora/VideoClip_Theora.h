@@ -22,6 +22,9 @@
 	#include <tremor/ivorbisfile.h>
 #endif
 
+#include <map>
+#include <vector>
+
 #include "AudioPacketQueue.h"
 #include "DataSource.h"
 #include "Utility.h"
@@ -48,6 +51,50 @@ namespace theoraplayer
 		vorbis_comment   VorbisComment;
 	};
 
+	/// @brief Second demuxer/decoder cursor that decodes the start of the next iteration of a looping clip ahead of time.
+	struct TheoraPrerollStruct
+	{
+		ogg_sync_state   OggSyncState;
+		ogg_page         OggPage;
+		ogg_stream_state TheoraStreamState;
+		th_dec_ctx*      TheoraDecoder;
+		/// @brief Clone of the clip's data source, so the cursor reads without moving the main cursor. NULL until the first pre-roll.
+		DataSource* stream;
+		/// @brief Post-processing level currently set in the decoder.
+		int decoderPostProcessingLevel;
+		/// @brief Whether the main cursor reached the end of the iteration and the frames of the next one are still to be decoded.
+		bool requested;
+		/// @brief Whether the cursor has been started for the upcoming iteration.
+		bool active;
+		/// @brief Frames of the next iteration, decoded in advance.
+		std::vector<VideoFrame*> frames;
+		OutputMode outputMode;
+		int decodedFramesCount;
+		/// @brief Number of frames handed over to the frame queue after the loop transition, -1 if no transition is in progress.
+		int deliveredFramesCount;
+	};
+
+	/// @brief Immutable header data shared by all clips of the same asset, so only the first clip has to parse the headers and scan for the duration.
+	struct TheoraSharedHeaders
+	{
+		std::string key;
+		int referencesCount;
+		th_info TheoraInfo;
+		th_setup_info* TheoraSetup;
+		/// @brief Holds the Vorbis codebooks, only valid if vorbisSerialNumber isn't -1.
+		vorbis_info VorbisInfo;
+		int theoraSerialNumber;
+		int vorbisSerialNumber;
+		int framesCount;
+	};
+
+	/// @brief Decoder state saved after decoding a frame, used to continue decoding from that frame after a seek.
+	struct TheoraCheckpoint
+	{
+		unsigned char* data;
+		size_t size;
+	};
+
 	class VideoClip_Theora : public VideoClip, public AudioPacketQueue
 	{
 	public:
@@ -60,11 +107,46 @@ namespace theoraplayer
 
 	protected:
 		TheoraInfoStruct info;
+		/// @brief Header data shared with other clips of the same asset, NULL if the clip owns its own.
+		TheoraSharedHeaders* sharedHeaders;
 		int theoraStreams;
 		/// @brief Keeps track of Theora and Vorbis Streams.
 		int vorbisStreams;
 		unsigned int readAudioSamples;
 		unsigned long lastDecodedFrameNumber;
+		/// @brief Post-processing level currently set in the decoder.
+		int decoderPostProcessingLevel;
+		TheoraPrerollStruct preroll;
+		/// @brief Decoder state checkpoints indexed by the frame number they were saved after.
+		std::map<int, TheoraCheckpoint> checkpoints;
+		int64_t checkpointsSize;
+		/// @brief Number of packets skipped since the last decoded one while only key frames are decoded.
+		int skippedPacketsCount;
+		/// @brief Frames decoded forward for reverse playback, handed to the frame queue from the back.
+		std::vector<VideoFrame*> reverseFrames;
+		OutputMode reverseOutputMode;
+		/// @brief Number of frames in reverseFrames that haven't been handed to the frame queue yet.
+		int reverseFramesCount;
+		/// @brief Frame number of the last frame the next reverse pass decodes, -1 once the first frame was decoded.
+		int reverseFrame;
+		/// @brief Whether changed macroblocks are tracked for incremental conversion.
+		bool dirtyTracking;
+		/// @brief Macroblocks that changed with each of the last decoded pictures, indexed by picture serial.
+		std::vector<unsigned char> dirtyHistory;
+		std::vector<unsigned char> dirtyMacroblocks;
+		/// @brief Serial of the picture the main decoder decoded last.
+		int pictureSerial;
+		/// @brief Pictures before this serial were decoded before the decoder was reset, so changes can't be tracked from them.
+		int dirtyBaseSerial;
+		/// @brief Serial of the picture last put into the frame queue.
+		int queuedPictureSerial;
+		/// @brief Holds the downscaled planes while the output is scaled.
+		std::vector<unsigned char> scaledPlanes;
+		/// @brief Region of the decoded frame that is converted, the whole frame unless the output is cropped.
+		int cropX;
+		int cropY;
+		int cropWidth;
+		int cropHeight;
 
 		void _load(DataSource* source);
 		bool _readData();
@@ -73,9 +155,68 @@ namespace theoraplayer
 		void _decodedAudioCheck();
 		void _executeSeek();
 		void _executeRestart();
+		void _executeScrub();
+		void _updateOutputSize();
 
 		long _seekPage(long targetFrame, bool returnKeyFrame);
+		/// @brief Resets the decoder and decodes the frames before the target frame, so the next decoded frame is the target frame.
+		/// @return False if the stream couldn't be read.
+		bool _seekDecoder(int targetFrame);
+		/// @brief Resets the decoder and positions the stream at the key frame before the given frame without decoding anything.
+		/// @return The key frame number or -1 if it couldn't be found, the stream has to be positioned again in that case.
+		long _seekKeyFrame(long frame);
+		/// @brief Positions the stream so the next Theora packet is the one of the given frame, without decoding the packets before it.
+		/// @return False if the packet couldn't be found, the stream has to be positioned again in that case.
+		bool _seekPacket(long frame);
 		void _readTheoraVorbisHeaders();
+		/// @brief Sets up the stream and header data from headers shared by another clip of the same asset instead of parsing them.
+		/// @return False if no other clip of this asset has been loaded.
+		bool _useSharedHeaders(const std::string& key);
+		/// @brief Makes the headers of this clip available to other clips of the same asset.
+		void _shareHeaders(const std::string& key);
+		void _releaseSharedHeaders();
+		/// @brief Sets the granule position so frames decoded from the start of the stream are numbered from 0.
+		void _setInitialGranulePos(th_dec_ctx* decoder);
+		void _decodeFrameBuffer(th_dec_ctx* decoder, VideoFrame* frame);
+		/// @brief Changes buffer to point to the region of the planes that is converted.
+		void _cropFrameBuffer(th_ycbcr_buffer buffer);
+		/// @brief Downscales the planes of a decoded picture to the output size, buffer is changed to point to the scaled planes.
+		void _scaleFrameBuffer(th_ycbcr_buffer buffer);
+		/// @brief Converts only the macroblocks that changed since the picture the frame holds, if it holds a recent picture of the main decoder.
+		void _decodeChangedMacroblocks(VideoFrame* frame);
+		/// @brief Records the macroblocks changed by the picture the main decoder just decoded.
+		void _trackDirtyMacroblocks();
+		/// @brief Combines the changes of all pictures decoded after the given one.
+		/// @return False if the changes since that picture aren't known anymore.
+		bool _accumulateDirtyMacroblocks(int pictureSerial, unsigned char* macroblocks);
+		/// @brief Called when the main decoder continues with a picture unrelated to the previous one.
+		void _resetDirtyMacroblocks();
+
+		/// @return False if the data source can't be cloned, the clip has to be restarted the regular way then.
+		bool _startPreroll();
+		bool _readPrerollData();
+		bool _isPrerollPending() const;
+		void _prerollNextFrame();
+		/// @brief Continues the next iteration from the pre-roll cursor instead of restarting the main cursor.
+		/// @return False if no frames were pre-rolled and the clip has to be restarted the regular way.
+		bool _continueFromPreroll();
+		bool _deliverPrerolledFrame(VideoFrame* frame);
+		void _resetPreroll();
+
+		/// @brief Hands the next frame of reverse playback to the frame queue.
+		bool _decodeReverseFrame(VideoFrame* frame);
+		/// @brief Decodes the frames up to reverseFrame that fit into the reverse frames budget.
+		void _decodeReverseFrames();
+
+		/// @brief Saves a checkpoint of the main decoder if one is due after the frame that was just decoded.
+		void _saveCheckpoint(int frameNumber);
+		/// @brief Restores the checkpoint nearest to the seek target and positions the stream at the packet following it.
+		/// @param[in] keyFrame The key frame preceding the seek target. Checkpoints before it aren't used.
+		/// @param[in] targetFrame The seek target.
+		/// @return The frame number of the restored checkpoint or -1 if the seek has to decode from the key frame.
+		int _restoreCheckpoint(int keyFrame, int targetFrame);
+		/// @brief Discards the checkpoints farthest away from frameNumber until the rest fits into memoryLimit.
+		void _trimCheckpoints(int frameNumber, int64_t memoryLimit);
 
 	};
 
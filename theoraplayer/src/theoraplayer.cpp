@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+#include "FrameCache/VideoClip_FrameCache.h"
 #include "Manager.h"
 #include "theoraplayer.h"
 #include "Utility.h"
@@ -42,6 +43,11 @@ namespace theoraplayer
 		theora.createFunction = &VideoClip_Theora::create;
 		registerVideoClipFormat(theora);
 #endif
+		VideoClip::Format frameCache;
+		frameCache.name = FRAME_CACHE_FORMAT_NAME;
+		frameCache.extension = FRAME_CACHE_EXTENSION;
+		frameCache.createFunction = &VideoClip_FrameCache::create;
+		registerVideoClipFormat(frameCache);
 		theoraplayer::manager->setWorkerThreadCount(workerThreadCount);
 	}
 